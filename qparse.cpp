@@ -5,6 +5,15 @@
 #include "qparseuser.h"
 #include "qparserequest.h"
 #include "qparsereply.h"
+#include "qparsecacheworker.h"
+#include "qparsedispatcher.h"
+#include "qparseoutbox.h"
+#include "qparsethrottle.h"
+#include "qparsestats.h"
+#include "qparsediskcache.h"
+#include "qparsetrace.h"
+#include "qparselogging.h"
+#include <QFutureInterface>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QNetworkRequest>
@@ -14,58 +23,371 @@
 #include <QUrlQuery>
 #include <QFile>
 #include <QFileInfo>
-#include <QDebug>
 #include <QElapsedTimer>
 #include <QStandardPaths>
 #include <QTimer>
 #include <QDir>
 #include <QSettings>
+#include <QCryptographicHash>
+#include <QThread>
+#include <QMutexLocker>
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <QCoreApplication>
 #include <QtQml>
 
-QParse::QParse(QObject *parent)
-	: QObject(parent) {
+//! the threads shared by all QParse clients (see sharedThread)
+static QMutex sharedThreadsMutex;
+static QThread* sharedCacheThread = NULL;
+static QThread* sharedNetworkThread = NULL;
+
+/*! return the shared thread, creating and starting it if not exists yet
+ *  The thread is stopped when the application quits
+ */
+static QThread* sharedThread( QThread*& thread, QString name ) {
+	QMutexLocker locker( &sharedThreadsMutex );
+	if ( !thread ) {
+		// no parent, it can be created from any thread
+		thread = new QThread();
+		thread->setObjectName( name );
+		thread->start();
+		QThread* created = thread;
+		if ( QCoreApplication::instance() ) {
+			QObject::connect( QCoreApplication::instance(), &QCoreApplication::aboutToQuit, [created]() {
+				created->quit();
+				created->wait();
+			});
+		}
+	}
+	return thread;
+}
+
+/*! true if the calling thread processes the events, so a dispatcher can live on it
+ *  and the replies can be delivered to it; the main thread runs (or it will run) the
+ *  event loop of the application, the other threads only while inside exec()
+ */
+static bool currentThreadHasEventLoop() {
+	QThread* thread = QThread::currentThread();
+	if ( QCoreApplication::instance() && thread == QCoreApplication::instance()->thread() ) {
+		return true;
+	}
+#if QT_VERSION >= QT_VERSION_CHECK(5, 5, 0)
+	return thread->loopLevel() > 0;
+#else
+	return true;
+#endif
+}
+
+//! the table of the CRC-32 used by gzip
+struct Crc32Table {
+	Crc32Table() {
+		for( quint32 i=0; i<256; i++ ) {
+			quint32 crc = i;
+			for( int bit=0; bit<8; bit++ ) {
+				crc = ( crc & 1 ) ? ( 0xEDB88320 ^ (crc >> 1) ) : ( crc >> 1 );
+			}
+			values[i] = crc;
+		}
+	}
+	quint32 values[256];
+};
+
+//! return the data compressed in gzip format (RFC 1952)
+static QByteArray gzipCompress( const QByteArray& data ) {
+	static const Crc32Table crcTable;
+	quint32 crc = 0xFFFFFFFF;
+	for( int i=0; i<data.size(); i++ ) {
+		crc = crcTable.values[(crc ^ quint8(data[i])) & 0xFF] ^ (crc >> 8);
+	}
+	crc ^= 0xFFFFFFFF;
+	// qCompress returns the size on 4 bytes followed by a zlib stream, that is
+	// 2 bytes of header, the deflate data and the adler-32 on 4 bytes
+	QByteArray zlib = qCompress( data, 6 );
+	QByteArray gzip;
+	static const char header[10] = { '\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, '\xff' };
+	gzip.append( header, 10 );
+	gzip.append( zlib.constData()+6, zlib.size()-6-4 );
+	quint32 size = quint32( data.size() );
+	for( int i=0; i<4; i++ ) {
+		gzip.append( char( (crc >> (8*i)) & 0xFF ) );
+	}
+	for( int i=0; i<4; i++ ) {
+		gzip.append( char( (size >> (8*i)) & 0xFF ) );
+	}
+	return gzip;
+}
+
+//! the names of the methods of OperationData::NetMethod
+static const char* netMethodNames[] = { "GET", "PUT", "POST", "DELETE" };
+
+/*! return the Json object of the data replied by PARSE
+ *  The replies that are a Json array (like the batch replies) are returned
+ *  as an object with the array into "results", like the replies of queries
+ */
+static QJsonObject jsonFromReplyData( QByteArray rawData ) {
+	QJsonDocument jsonDoc = QJsonDocument::fromJson( rawData );
+	if ( jsonDoc.isArray() ) {
+		QJsonObject data;
+		data["results"] = jsonDoc.array();
+		return data;
+	}
+	return jsonDoc.object();
+}
+
+QParse::QParse( QString cacheNamespace, QObject *parent )
+	: QObject(parent)
+	, baseUrl("https://api.parse.com/1")
+	, cacheNamespace(cacheNamespace) {
 	// register metatypes
-	qRegisterMetaType<QParseDate>("QParseDate");
-	//qRegisterMetaType<QParseFile>("QParseFile");
-	qmlRegisterType<QParseFile>("org.gmaxera.qparse", 1, 0, "ParseFile");
-	// initialize the singleton
+	static bool registered = false;
+	if ( !registered ) {
+		registered = true;
+		qRegisterMetaType<QParseDate>("QParseDate");
+		qRegisterMetaType<QParseReply*>("QParseReply*");
+		qRegisterMetaType<QParseResult>("QParseResult");
+		//qRegisterMetaType<QParseFile>("QParseFile");
+		qmlRegisterType<QParseFile>("org.gmaxera.qparse", 1, 0, "ParseFile");
+	}
+	// initialize the client
+	// !! keep this fast, it's usually called during the launch of the app;
+	// !! the cache index is loaded by the worker, and requests are held until it's ready
+	startupTimer.start();
+	ready.storeRelease( 0 );
+	pendingConfigPull = false;
+	pendingConfigForceNetwork = false;
 	cacheDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)+"/QParseCache";
-	qDebug() << "QParse CACHEDIR: " << cacheDir;
-	QDir dir(cacheDir);
-	dir.mkpath(cacheDir);
+	if ( !cacheNamespace.isEmpty() ) {
+		cacheDir += "/"+cacheNamespace;
+	}
+	qparseDebug( qparseCache ) << "cache directory" << cacheDir;
 	cacheIni = "cache.ini";
+	cacheCompression = false;
+	cacheCompressionThreshold = 4096;
+	useNetworkThread = false;
+	throttle = new QParseThrottle(this);
+	stats = new QParseStats(this);
+	httpCache = new QParseDiskCacheStore( cacheDir+"/http", stats, this );
+	// all the disk I/O of the cache is done by the worker on the cache thread shared by all clients
+	cacheWorker = new QParseCacheWorker();
+	QThread* cacheThread = sharedThread( sharedCacheThread, "QParseCache" );
+	cacheWorker->moveToThread( cacheThread );
+	// write down anything still on the queue before the thread quits
+	connect( cacheThread, &QThread::finished, cacheWorker, &QParseCacheWorker::flush, Qt::DirectConnection );
+	connect( cacheThread, &QThread::finished, cacheWorker, &QObject::deleteLater );
+	connect( cacheWorker, &QParseCacheWorker::readFinished, this, &QParse::onCacheReadFinished );
+	connect( cacheWorker, &QParseCacheWorker::writeFinished, this, &QParse::onCacheWriteFinished );
+	connect( cacheWorker, &QParseCacheWorker::indexLoaded, this, &QParse::onCacheIndexLoaded );
 	loadCacheInfoData();
 	loadInstallation();
 	user = NULL;
-	net = new QNetworkAccessManager(this);
-	connect( net, SIGNAL(finished(QNetworkReply*)), this, SLOT(onRequestFinished(QNetworkReply*)) );
-	// set the timer for processing the queue
-	timer = new QTimer(this);
-	timer->setInterval(0);
-	timer->setSingleShot(false);
-	connect( timer, &QTimer::timeout, this, &QParse::processOperationsQueue );
-	timer->start();
+	// the dispatcher of this thread is used also for installation and app config requests
+	net = getThreadDispatcher()->getNet();
+	connect( net, &QNetworkAccessManager::networkAccessibleChanged, this, &QParse::onNetworkAccessibleChanged );
+	offlineWrites = false;
+	outbox = new QParseOutbox( this, cacheWorker, net, cacheDir+"/outbox.json" );
+	prewarmConnections = false;
+	http2Allowed = true;
+	requestCompression = false;
+	requestCompressionThreshold = 1024;
+	resetConnectionStats();
+	connect( this, &QParse::appIdChanged, this, &QParse::prewarm );
+	connect( this, &QParse::restKeyChanged, this, &QParse::prewarm );
+	connect( this, &QParse::baseUrlChanged, this, &QParse::prewarm );
+	// requests will be processed as soon as the cache index is loaded
+	traceStartup( "constructed" );
+}
+
+QParse::~QParse() {
+	// the outbox would handle its cancelled writes while the client is going away
+	delete outbox;
+	outbox = NULL;
+	QMutexLocker locker( &dispatchersMutex );
+	QList<QParseDispatcher*> released = dispatchers.values();
+	dispatchers.clear();
+	locker.unlock();
+	foreach( QParseDispatcher* dispatcher, released ) {
+		QThread* thread = dispatcher->thread();
+		disconnect( thread, 0, dispatcher, 0 );
+		// the dispatcher has to drop its requests before the client is gone
+		if ( thread == QThread::currentThread() ) {
+			dispatcher->shutdown();
+		} else if ( thread->isRunning() ) {
+			QMetaObject::invokeMethod( dispatcher, "shutdown", Qt::BlockingQueuedConnection );
+		}
+	}
+	QMutexLocker pendingLocker( &mutex );
+	QList<OperationData*> waiting = cacheReadsPending.values() + cacheWritesPending.values();
+	cacheReadsPending.clear();
+	cacheWritesPending.clear();
+	pendingLocker.unlock();
+	foreach( OperationData* opdata, waiting ) {
+		cancelOperation( opdata );
+	}
+	// the worker writes down the pending data on its thread, then it's deleted there;
+	// if the cache thread has already finished, the worker was flushed and deleted with it
+	QMutexLocker threadsLocker( &sharedThreadsMutex );
+	if ( sharedCacheThread && sharedCacheThread->isRunning() ) {
+		QMetaObject::invokeMethod( cacheWorker, "flush", Qt::QueuedConnection );
+		cacheWorker->deleteLater();
+	}
+}
+
+QAtomicPointer<QQmlNetworkAccessManagerFactory> QParse::networkFactory;
+
+void QParse::setNetworkAccessManagerFactory( QQmlNetworkAccessManagerFactory* factory ) {
+	networkFactory.storeRelease( factory );
+}
+
+QQmlNetworkAccessManagerFactory* QParse::getNetworkAccessManagerFactory() {
+	return networkFactory.loadAcquire();
+}
+
+QAtomicPointer<QParseTransportFactory> QParse::transportFactory;
+
+void QParse::setTransportFactory( QParseTransportFactory* factory ) {
+	transportFactory.storeRelease( factory );
+}
+
+QParseTransportFactory* QParse::getTransportFactory() {
+	return transportFactory.loadAcquire();
 }
 
 QParse* QParse::instance() {
-	static QParse* singleton = new QParse();
+	// the singleton uses the root of the cache directory
+	static QParse* singleton = new QParse( QString() );
 	return singleton;
 }
 
+QObject* QParse::parentForCurrentThread( QParse* parse ) {
+	if ( !parse ) {
+		parse = QParse::instance();
+	}
+	if ( parse->thread() == QThread::currentThread() ) {
+		return parse;
+	}
+	return NULL;
+}
+
+QParseDispatcher* QParse::getDispatcher() {
+	QMutexLocker locker( &mutex );
+	bool networkThread = useNetworkThread;
+	locker.unlock();
+	// the threads without event loop would never process the requests
+	if ( !networkThread && currentThreadHasEventLoop() ) {
+		return getThreadDispatcher();
+	}
+	// each client has its own dispatcher (and connections), but the network thread is shared
+	return getDispatcherOf( sharedThread( sharedNetworkThread, "QParseNetwork" ) );
+}
+
+QParseDispatcher* QParse::getThreadDispatcher() {
+	return getDispatcherOf( QThread::currentThread() );
+}
+
+QParseDispatcher* QParse::getDispatcherOf( QThread* thread ) {
+	QMutexLocker locker( &dispatchersMutex );
+	QParseDispatcher* dispatcher = dispatchers.value( thread );
+	if ( dispatcher ) return dispatcher;
+	// the network manager and the timer are children, so they move together with the dispatcher
+	dispatcher = new QParseDispatcher(this);
+	if ( thread != QThread::currentThread() ) {
+		dispatcher->moveToThread( thread );
+	}
+	dispatchers[thread] = dispatcher;
+	// a dispatcher can not outlive its thread; it's called on the exiting thread,
+	// and the deferred deletion is done before the thread finishes
+	connect( thread, &QThread::finished, dispatcher, [this, thread]() {
+		QMutexLocker locker( &dispatchersMutex );
+		QParseDispatcher* exited = dispatchers.take( thread );
+		locker.unlock();
+		if ( exited ) {
+			// the requests still on it are finished as cancelled, then it's deleted
+			exited->shutdown();
+		}
+	}, Qt::DirectConnection );
+	return dispatcher;
+}
+
+void QParse::enqueueOn( OperationData* opdata ) {
+	QMutexLocker locker( &dispatchersMutex );
+	// the dispatcher is alive while it's registered, and it's taken out before its deletion
+	if ( dispatchers.values().contains( opdata->dispatcher ) ) {
+		opdata->dispatcher->enqueue( opdata );
+		return;
+	}
+	locker.unlock();
+	// the thread of the dispatcher exited in the meantime
+	opdata->dispatcher = getDispatcher();
+	opdata->dispatcher->enqueue( opdata );
+}
+
+void QParse::abortReply( QParseReply* reply ) {
+	QMutexLocker locker( &dispatchersMutex );
+	// the dispatcher not processing the request ignores it; the queued calls are
+	// discarded if a dispatcher is deleted before processing them
+	foreach( QParseDispatcher* dispatcher, dispatchers ) {
+		QMetaObject::invokeMethod( dispatcher, "abort", Qt::QueuedConnection, Q_ARG(QParseReply*, reply) );
+	}
+}
+
+bool QParse::isReady() const {
+	return ready.loadAcquire() != 0;
+}
+
+QVariantMap QParse::getStartupTimings() const {
+	return startupTimings;
+}
+
+QUrl QParse::getBaseUrl() const {
+	QMutexLocker locker( &mutex );
+	return baseUrl;
+}
+
+void QParse::setBaseUrl( const QUrl& value ) {
+	QMutexLocker locker( &mutex );
+	if ( baseUrl == value ) return;
+	baseUrl = value;
+	locker.unlock();
+	emit baseUrlChanged( value );
+}
+
+QString QParse::getCacheNamespace() const {
+	return cacheNamespace;
+}
+
+QUrl QParse::getEndpoint( QString path ) const {
+	QMutexLocker locker( &mutex );
+	QString prefix = baseUrl.toString();
+	if ( prefix.endsWith("/") ) {
+		prefix.chop(1);
+	}
+	return QUrl( prefix+"/"+path );
+}
+
 QString QParse::getRestKey() const {
+	QMutexLocker locker( &mutex );
 	return restKey;
 }
 
 void QParse::setRestKey(const QString &value) {
+	QMutexLocker locker( &mutex );
+	if ( restKey == value ) return;
 	restKey = value;
+	locker.unlock();
+	emit restKeyChanged( value );
 }
 
 QString QParse::getAppId() const {
+	QMutexLocker locker( &mutex );
 	return appId;
 }
 
 void QParse::setAppId(const QString &value) {
+	QMutexLocker locker( &mutex );
+	if ( appId == value ) return;
 	appId = value;
+	locker.unlock();
+	emit appIdChanged( value );
 }
 
 QString QParse::getGCMSenderId() {
@@ -76,26 +398,222 @@ void QParse::setGCMSenderId(const QString& value) {
 	gcmSenderId = value;
 }
 
+bool QParse::getCacheCompression() const {
+	return cacheCompression;
+}
+
+void QParse::setCacheCompression( bool value ) {
+	if ( cacheCompression == value ) return;
+	cacheCompression = value;
+	emit cacheCompressionChanged( cacheCompression );
+}
+
+bool QParse::getUseNetworkThread() const {
+	QMutexLocker locker( &mutex );
+	return useNetworkThread;
+}
+
+void QParse::setUseNetworkThread( bool value ) {
+	QMutexLocker locker( &mutex );
+	if ( useNetworkThread == value ) return;
+	useNetworkThread = value;
+	locker.unlock();
+	emit useNetworkThreadChanged( value );
+}
+
+bool QParse::getOfflineWrites() const {
+	return offlineWrites;
+}
+
+void QParse::setOfflineWrites( bool value ) {
+	if ( offlineWrites == value ) return;
+	offlineWrites = value;
+	emit offlineWritesChanged( offlineWrites );
+}
+
+QParseOutbox* QParse::getOutbox() const {
+	return outbox;
+}
+
+double QParse::getRequestRateLimit() const {
+	return throttle->getRateLimit();
+}
+
+void QParse::setRequestRateLimit( double value ) {
+	if ( throttle->getRateLimit() == value ) return;
+	throttle->setRateLimit( value );
+	emit requestRateLimitChanged( value );
+}
+
+int QParse::getConcurrencyLimit() const {
+	return throttle->getConcurrencyLimit();
+}
+
+bool QParse::getPrewarmConnections() const {
+	return prewarmConnections;
+}
+
+void QParse::setPrewarmConnections( bool value ) {
+	if ( prewarmConnections == value ) return;
+	prewarmConnections = value;
+	emit prewarmConnectionsChanged( value );
+	prewarm();
+}
+
+int QParse::getConnectionPoolSize() const {
+	return throttle->getMaxConcurrency();
+}
+
+void QParse::setConnectionPoolSize( int value ) {
+	if ( throttle->getMaxConcurrency() == value ) return;
+	throttle->setMaxConcurrency( value );
+	emit connectionPoolSizeChanged( value );
+}
+
+bool QParse::getHttp2Allowed() const {
+	QMutexLocker locker( &mutex );
+	return http2Allowed;
+}
+
+void QParse::setHttp2Allowed( bool value ) {
+	QMutexLocker locker( &mutex );
+	if ( http2Allowed == value ) return;
+	http2Allowed = value;
+	locker.unlock();
+	emit http2AllowedChanged( value );
+}
+
+bool QParse::getRequestCompression() const {
+	QMutexLocker locker( &mutex );
+	return requestCompression;
+}
+
+void QParse::setRequestCompression( bool value ) {
+	QMutexLocker locker( &mutex );
+	if ( requestCompression == value ) return;
+	requestCompression = value;
+	locker.unlock();
+	emit requestCompressionChanged( value );
+}
+
+int QParse::getRequestCompressionThreshold() const {
+	QMutexLocker locker( &mutex );
+	return requestCompressionThreshold;
+}
+
+void QParse::setRequestCompressionThreshold( int value ) {
+	QMutexLocker locker( &mutex );
+	if ( requestCompressionThreshold == value ) return;
+	requestCompressionThreshold = value;
+	locker.unlock();
+	emit requestCompressionThresholdChanged( value );
+}
+
+QVariantMap QParse::getConnectionStats() const {
+	QVariantMap stats;
+	int requests = statsRequests.loadAcquire();
+	int handshakes = statsHandshakes.loadAcquire();
+	stats["requests"] = requests;
+	stats["handshakes"] = handshakes;
+	stats["reusedRequests"] = qMax( 0, requests-handshakes );
+	stats["http2Requests"] = statsHttp2Requests.loadAcquire();
+	stats["firstRequestLatency"] = statsFirstRequestLatency.loadAcquire();
+	stats["requestBytesSaved"] = statsRequestBytesSaved.loadAcquire();
+	return stats;
+}
+
+void QParse::resetConnectionStats() {
+	statsRequests.storeRelease( 0 );
+	statsHandshakes.storeRelease( 0 );
+	statsHttp2Requests.storeRelease( 0 );
+	statsFirstRequestLatency.storeRelease( -1 );
+	statsRequestBytesSaved.storeRelease( 0 );
+}
+
+QParseStats* QParse::getStats() const {
+	return stats;
+}
+
+QParseDiskCacheStore* QParse::getHttpCache() const {
+	return httpCache;
+}
+
+qint64 QParse::getHttpCacheSize() const {
+	return httpCache->getMaximumSize();
+}
+
+void QParse::setHttpCacheSize( qint64 value ) {
+	if ( httpCache->getMaximumSize() == value ) return;
+	httpCache->setMaximumSize( value );
+	emit httpCacheSizeChanged( value );
+}
+
+QString QParse::getCaptureFile() const {
+	QMutexLocker locker( &mutex );
+	return captureFile;
+}
+
+void QParse::setCaptureFile( QString value ) {
+	QMutexLocker locker( &mutex );
+	if ( captureFile == value ) return;
+	captureFile = value;
+	QUrl url = baseUrl;
+	locker.unlock();
+	if ( value.isEmpty() ) {
+		capture.close();
+	} else {
+		capture.open( value, url );
+	}
+	emit captureFileChanged( value );
+}
+
+void QParse::prewarm() {
+	if ( !prewarmConnections ) return;
+	QMutexLocker locker( &mutex );
+	if ( appId.isEmpty() || restKey.isEmpty() ) return;
+	QUrl url = baseUrl;
+	// with HTTP/2 one connection serves all the requests
+	int connections = http2Allowed ? 1 : 6;
+	bool http2 = http2Allowed;
+	bool networkThread = useNetworkThread;
+	locker.unlock();
+	connections = qMin( connections, getConnectionPoolSize() );
+	qparseDebug( qparseNetwork ) << "prewarm" << connections << "connections to" << url.host();
+	QMetaObject::invokeMethod( getThreadDispatcher(), "prewarm", Qt::QueuedConnection,
+							   Q_ARG(QUrl, url), Q_ARG(int, connections), Q_ARG(bool, http2) );
+	if ( networkThread ) {
+		QMetaObject::invokeMethod( getDispatcher(), "prewarm", Qt::QueuedConnection,
+								   Q_ARG(QUrl, url), Q_ARG(int, connections), Q_ARG(bool, http2) );
+	}
+}
+
+int QParse::getCacheCompressionThreshold() const {
+	return cacheCompressionThreshold;
+}
+
+void QParse::setCacheCompressionThreshold( int value ) {
+	if ( cacheCompressionThreshold == value ) return;
+	cacheCompressionThreshold = value;
+	emit cacheCompressionThresholdChanged( cacheCompressionThreshold );
+}
+
 QJsonValue QParse::getAppConfigValue( QString key ) {
 	return appConfig[key];
 }
 
 void QParse::pullAppConfigValues( bool forceNetwork ) {
-	if ( !forceNetwork && isRequestCached(QUrl("https://api.parse.com/1/config")) ) {
-		QJsonObject data = getCachedJson( QUrl("https://api.parse.com/1/config") );
-		if ( data.contains("params") ) {
-			appConfig = data["params"].toObject();
-			emit appConfigChanged();
-		}
+	if ( !isReady() ) {
+		// without the cache index it's not possible to know if it's cached; it will be pulled when ready
+		pendingConfigPull = true;
+		pendingConfigForceNetwork = pendingConfigForceNetwork || forceNetwork;
+		return;
+	}
+	if ( !forceNetwork && isRequestCached(getEndpoint("config")) ) {
+		// the cached data will be handled on onCacheReadFinished
+		readCachedData( getEndpoint("config") );
 	} else {
 		// direct request, the reply will be handled on onRequestFinished
-		QNetworkRequest request(QUrl("https://api.parse.com/1/config"));
-		request.setRawHeader("X-Parse-Application-Id", appId.toLatin1());
-		request.setRawHeader("X-Parse-REST-API-Key", restKey.toLatin1());
-		if ( user ) {
-			// if there is a user logged in, send also the session token
-			request.setRawHeader("X-Parse-Session-Token", user->getToken().toLatin1());
-		}
+		QNetworkRequest request = createNetworkRequest( getEndpoint("config") );
 		net->get(request);
 	}
 }
@@ -118,30 +636,22 @@ void QParse::pullInstallation() {
 	if ( !installationChangedKeys.isEmpty() ) return;
 	// Prepare the request
 	// direct request, the reply will be handled on onRequestFinished
-	QNetworkRequest request(QUrl(QString("https://api.parse.com/1/installations/")+installation["objectId"].toString()));
-	request.setRawHeader("X-Parse-Application-Id", appId.toLatin1());
-	request.setRawHeader("X-Parse-REST-API-Key", restKey.toLatin1());
-	if ( user ) {
-		// if there is a user logged in, send also the session token
-		request.setRawHeader("X-Parse-Session-Token", user->getToken().toLatin1());
-	}
+	QNetworkRequest request = createNetworkRequest( getEndpoint("installations/"+installation["objectId"].toString()) );
 	request.setRawHeader("Content-Type", "application/json");
 	net->get( request );
 }
 
 void QParse::pushInstallation() {
-	if ( net->networkAccessible() != QNetworkAccessManager::Accessible ) return;
 	if ( !installation.contains("objectId") ) return;
 	if ( installationChangedKeys.isEmpty() ) return;
+	if ( net->networkAccessible() != QNetworkAccessManager::Accessible ) {
+		// keep the changes on disk, they will be pushed when the network is accessible again
+		saveInstallation();
+		return;
+	}
 	// Prepare the request
 	// direct request, the reply will be handled on onRequestFinished
-	QNetworkRequest request(QUrl(QString("https://api.parse.com/1/installations/")+installation["objectId"].toString()));
-	request.setRawHeader("X-Parse-Application-Id", appId.toLatin1());
-	request.setRawHeader("X-Parse-REST-API-Key", restKey.toLatin1());
-	if ( user ) {
-		// if there is a user logged in, send also the session token
-		request.setRawHeader("X-Parse-Session-Token", user->getToken().toLatin1());
-	}
+	QNetworkRequest request = createNetworkRequest( getEndpoint("installations/"+installation["objectId"].toString()) );
 	request.setRawHeader("Content-Type", "application/json");
 	QJsonObject changes;
 	foreach( QString key, installationChangedKeys ) {
@@ -151,6 +661,12 @@ void QParse::pushInstallation() {
 	net->put( request, jsonDoc.toJson(QJsonDocument::Compact) );
 }
 
+void QParse::onNetworkAccessibleChanged( QNetworkAccessManager::NetworkAccessibility accessible ) {
+	if ( accessible == QNetworkAccessManager::Accessible ) {
+		pushInstallation();
+	}
+}
+
 void QParse::subscribeToChannels( QStringList channels ) {
 	// check if there is a valid local installation data
 	if ( !installation.contains("objectId") ) return;
@@ -180,8 +696,33 @@ QParseUser* QParse::getMe() {
 }
 
 QParseReply* QParse::get( QParseRequest* request ) {
-	QParseReply* reply = new QParseReply(request, this);
-	if ( request->getParseFile() && request->getParseFile()->isValid() ) {
+	OperationData* data = createOperation( request, OperationData::GET );
+	enqueueOperation( data );
+	return data->parseReply;
+}
+
+QParseReply* QParse::post( QParseRequest* request ) {
+	OperationData* data = createOperation( request, OperationData::POST );
+	enqueueOperation( data );
+	return data->parseReply;
+}
+
+QParseReply* QParse::put( QParseRequest* request ) {
+	OperationData* data = createOperation( request, OperationData::PUT );
+	enqueueOperation( data );
+	return data->parseReply;
+}
+
+QParseReply* QParse::deleteResource( QParseRequest* request ) {
+	OperationData* data = createOperation( request, OperationData::DELETE );
+	enqueueOperation( data );
+	return data->parseReply;
+}
+
+QParse::OperationData* QParse::createOperation( QParseRequest* request, OperationData::NetMethod netMethod ) {
+	QParseReply* reply = new QParseReply(request, static_cast<QParse*>(parentForCurrentThread(this)));
+	// only the files got from PARSE are not Json
+	if ( netMethod == OperationData::GET && request->getParseFile() && request->getParseFile()->isValid() ) {
 		reply->setIsJson( false );
 	} else {
 		reply->setIsJson( true );
@@ -191,111 +732,218 @@ QParseReply* QParse::get( QParseRequest* request ) {
 	OperationData* data = new OperationData();
 	data->parseRequest = request;
 	data->parseReply = reply;
-	data->netMethod = QParse::OperationData::GET;
-	operationsQueue.enqueue( data );
-	return reply;
+	data->netMethod = netMethod;
+	if ( netMethod == OperationData::POST || netMethod == OperationData::PUT ) {
+		data->dataToPost = request->getBody();
+		if ( data->dataToPost.isEmpty() && request->getParseObject() ) {
+			data->dataToPost = request->getParseObject()->toJson();
+		}
+	}
+	return data;
 }
 
-QParseReply* QParse::post( QParseRequest* request ) {
-	QParseReply* reply = new QParseReply(request, this);
-	reply->setIsJson( true );
-	// reparent QParseRequest to be destroyed with QParseReply later
-	request->setParent(reply);
-	OperationData* data = new OperationData();
-	data->parseRequest = request;
-	data->parseReply = reply;
-	data->netMethod = QParse::OperationData::POST;
-	data->dataToPost = request->getParseObject()->toJson();
-	operationsQueue.enqueue( data );
-	return reply;
+void QParse::enqueueOperation( OperationData* data ) {
+	data->submittedTimer.start();
+	QPARSE_TRACE( "request", 'b', data->parseReply );
+	// the objectId is not part of the endpoint, so all the objects of a class are together
+	QString className = data->parseRequest->getParseClassName();
+	if ( data->parseRequest->getParseFile() ) {
+		className = "files";
+	} else if ( className == "_Users" ) {
+		className = "users";
+	} else if ( className != "login" && className != "batch" ) {
+		className = "classes/"+className;
+	}
+	data->statsEndpoint = QString("%1 %2").arg( netMethodNames[data->netMethod] ).arg( className );
+	data->dispatcher = getDispatcher();
+	data->parseReply->client.storeRelease( this );
+	if ( !currentThreadHasEventLoop() && !data->parseReply->parent() ) {
+		// the calling thread would never receive the finished signal, so the reply
+		// (and its request) is finished on the thread of the dispatcher
+		data->parseReply->moveToThread( data->dispatcher->thread() );
+	}
+	int deadline = data->parseRequest->getDeadline();
+	if ( deadline > 0 ) {
+		QParseReply* reply = data->parseReply;
+		// the timer lives on the calling thread, like the reply
+		QTimer::singleShot( deadline, reply, [reply]() {
+			reply->abort();
+		});
+	}
+	data->dispatcher->enqueue( data );
 }
 
-QParseReply* QParse::put( QParseRequest* request ) {
-	QParseReply* reply = new QParseReply(request, this);
-	reply->setIsJson( true );
-	// reparent QParseRequest to be destroyed with QParseReply later
-	request->setParent(reply);
-	OperationData* data = new OperationData();
-	data->parseRequest = request;
-	data->parseReply = reply;
-	data->netMethod = QParse::OperationData::PUT;
-	data->dataToPost = request->getParseObject()->toJson();
-	operationsQueue.enqueue( data );
-	return reply;
+void QParse::recordStage( OperationData* opdata, QString metric, qint64 from, qint64 to ) {
+	if ( from < 0 || to < 0 ) return;
+	stats->record( opdata->statsEndpoint, metric, (to-from)/1000000.0 );
+}
+
+void QParse::cancelOperation( OperationData* opdata ) {
+	opdata->parseReply->setHasError( true );
+	opdata->parseReply->setErrorCode( QNetworkReply::OperationCanceledError );
+	opdata->parseReply->setErrorMessage( "Operation canceled" );
+	finishReply( opdata );
+}
+
+QFuture<QParseResult> QParse::getAsync( QParseRequest* request ) {
+	return submitAsync( createOperation( request, OperationData::GET ) );
 }
 
-void QParse::onRequestFinished(QNetworkReply *reply) {
-	qDebug() << "REPLY FROM PARSE" << reply->url();
-	if ( !operationsPending.contains(reply) ) {
+QFuture<QParseResult> QParse::postAsync( QParseRequest* request ) {
+	return submitAsync( createOperation( request, OperationData::POST ) );
+}
+
+QFuture<QParseResult> QParse::putAsync( QParseRequest* request ) {
+	return submitAsync( createOperation( request, OperationData::PUT ) );
+}
+
+QFuture<QParseResult> QParse::submitAsync( OperationData* data ) {
+	// connected before enqueuing, as the reply can be finished at once on another thread
+	QFuture<QParseResult> future = toFuture( data->parseReply );
+	enqueueOperation( data );
+	return future;
+}
+
+QFuture<QParseResult> QParse::toFuture( QParseReply* reply ) {
+	QFutureInterface<QParseResult> futureInterface;
+	futureInterface.reportStarted();
+	// the lambda is called on the thread of the reply, also when it's moved by enqueueOperation
+	connect( reply, &QParseReply::finished, reply, [futureInterface](QParseReply* reply) mutable {
+		QParseResult result( reply );
+		futureInterface.reportResult( result );
+		futureInterface.reportFinished();
+		reply->deleteLater();
+	});
+	return futureInterface.future();
+}
+
+void QParse::onRequestFinished( QParseDispatcher* dispatcher, QNetworkReply *reply ) {
+	qparseDebug( qparseNetwork ) << "reply from" << reply->url() << reply->error();
+	if ( !dispatcher->operationsPending.contains(reply) ) {
 		// check the special case of PARSE App Config
-		if ( reply->url() == QUrl("https://api.parse.com/1/config") ) {
+		if ( reply->url() == getEndpoint("config") ) {
 			if ( reply->error() == QNetworkReply::NoError ) {
-				updateCache( reply, NULL );
-				QJsonObject data = getCachedJson( reply->url() );
-				if ( data.contains("params") ) {
-					appConfig = data["params"].toObject();
-					emit appConfigChanged();
-				}
+				QByteArray rawData = reply->readAll();
+				updateCache( reply->url(), rawData, NULL );
+				updateAppConfig( rawData );
 			}
 		// check the special case of PARSE Installation
-		} else if ( reply->url()==QUrl("https://api.parse.com/1/installations") ||
-					QUrl("https://api.parse.com/1/installations").isParentOf(reply->url()) ) {
+		} else if ( reply->url()==getEndpoint("installations") ||
+					getEndpoint("installations").isParentOf(reply->url()) ) {
 			if ( reply->error() == QNetworkReply::NoError ) {
 				QJsonObject data = QJsonDocument::fromJson( reply->readAll() ).object();
 				if ( data.contains("error") ) {
-					qDebug() << "ERROR ON INSTALLATION: " << data;
+					qparseWarning( qparseInstallation ) << "error on installation" << qparseLoggedPayload( data );
 				} else if ( reply->operation() != QNetworkAccessManager::PutOperation ) {
 					// GET or POST, in both case update the local object
 					foreach( QString key, data.keys() ) {
 						installation[key] = data[key];
 					}
 					saveInstallation();
-					qDebug() << "INSTALLATION REPLY" << installation;
+					qparseDebug( qparseInstallation ) << "installation reply" << qparseLoggedPayload( installation );
 				} else {
 					// PUT operation
 					installationChangedKeys.clear();
 					saveInstallation();
-					qDebug() << "PUSHED CHANGES" << data;
+					qparseDebug( qparseInstallation ) << "pushed changes" << qparseLoggedPayload( data );
 				}
 			} else {
-				qDebug() << "ERROR: " << reply->errorString();
+				qparseWarning( qparseInstallation ) << "installation not pushed" << reply->errorString();
 			}
 		} else {
-			qDebug() << "QParse Error - Not reply into operations map !!";
+			qparseWarning( qparseNetwork ) << "reply not into operations map" << reply->url();
 		}
 		return;
 	}
-	OperationData* opdata = operationsPending.take(reply);
+	OperationData* opdata = dispatcher->operationsPending.take(reply);
+	QPARSE_TRACE( "networkFinished", 'n', opdata->parseReply );
+	QByteArray rawData = reply->readAll();
+	qint64 finishedAt = opdata->submittedTimer.nsecsElapsed();
+	recordStage( opdata, "ttfb", opdata->sentAt, opdata->firstByteAt );
+	recordStage( opdata, "download", opdata->firstByteAt, finishedAt );
+	statsFirstRequestLatency.testAndSetOrdered( -1, int(opdata->sentTimer.elapsed()) );
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+	if ( reply->attribute( QNetworkRequest::Http2WasUsedAttribute ).toBool() ) {
+		statsHttp2Requests.ref();
+	}
+#elif QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+	if ( reply->attribute( QNetworkRequest::HTTP2WasUsedAttribute ).toBool() ) {
+		statsHttp2Requests.ref();
+	}
+#endif
+	int httpStatus = reply->attribute( QNetworkRequest::HttpStatusCodeAttribute ).toInt();
+	opdata->parseReply->setHttpStatus( httpStatus );
+	QJsonObject errorData;
+	if ( reply->error() != QNetworkReply::NoError ) {
+		errorData = QJsonDocument::fromJson( rawData ).object();
+	}
+	// PARSE replies with 429 and the error 155 when the requests exceed the quota of the app
+	bool throttled = httpStatus == 429 || errorData["code"].toInt() == 155;
+	// the latency is the time to the first byte, as the download depends on the size;
+	// the files, and the requests aborted or that did not reach PARSE, say nothing about it
+	qint64 latency = -1;
+	if ( opdata->firstByteAt >= 0 && !opdata->parseRequest->getParseFile()
+		 && ( reply->error() == QNetworkReply::NoError || errorData.contains("error") ) ) {
+		latency = (opdata->firstByteAt - opdata->sentAt)/1000000;
+	}
+	throttle->release( latency, throttled );
+	if ( throttled && opdata->retries < QParseThrottle::maxRetries ) {
+		opdata->retries++;
+		int backoff = QParseThrottle::getBackoff( opdata->retries );
+		qparseDebug( qparseNetwork ) << "throttled by PARSE, retry in" << backoff << "ms" << reply->url();
+		dispatcher->retry( opdata, backoff );
+		return;
+	}
+	// only the final outcome is recorded, the replay does not retry
+	if ( capture.isOpen() ) {
+		double ttfb = opdata->firstByteAt >= 0 ? (opdata->firstByteAt - opdata->sentAt)/1000000.0 : -1;
+		capture.record( reply->request(), netMethodNames[opdata->netMethod], opdata->sentBody,
+						reply, rawData, opdata->sentTimer.elapsed(), ttfb );
+	}
 	// check for any errors
 	if ( reply->error() != QNetworkReply::NoError ) {
 		opdata->parseReply->setHasError( true );
-		QJsonObject data = QJsonDocument::fromJson( reply->readAll() ).object();
+		QJsonObject data = errorData;
 		if ( data.contains("error") ) {
 			opdata->parseReply->setErrorMessage( data["error"].toString() );
 			opdata->parseReply->setErrorCode( data["code"].toInt() );
-			qDebug() << "PARSE ERROR" << data;
+			qparseDebug( qparseNetwork ) << "PARSE error" << reply->url() << qparseLoggedPayload( data );
 		} else {
 			opdata->parseReply->setErrorMessage( reply->errorString() );
 			opdata->parseReply->setErrorCode( reply->error() );
-			qDebug() << "NETWORK ERROR" << reply->errorString();
+			// an aborted request is not a failure of the network
+			opdata->parseReply->setNetworkError( reply->error() != QNetworkReply::OperationCanceledError );
+			qparseDebug( qparseNetwork ) << "network error" << reply->url() << reply->errorString();
 		}
 		// emit the signal and terminates
-		emit (opdata->parseReply->finished(opdata->parseReply));
+		finishReply( opdata );
 		return;
 	}
 	// cache the reply, and prepare QParseReply
-	updateCache( reply, opdata );
-	fillWithCachedData( opdata->netRequest->url(), opdata->parseReply );
-	emit (opdata->parseReply->finished(opdata->parseReply));
+	if ( opdata->netMethod == QParse::OperationData::GET ) {
+		// only the data got from PARSE are cached; the replies to writes are not
+		updateCache( reply->url(), rawData, opdata );
+	}
+	if ( opdata->parseReply->getIsJson() ) {
+		// data is already here, there is no need to read it back from the cache
+		qint64 parseStart = opdata->submittedTimer.nsecsElapsed();
+		opdata->parseReply->setJson( jsonFromReplyData( rawData ) );
+		recordStage( opdata, "jsonParse", parseStart, opdata->submittedTimer.nsecsElapsed() );
+		finishReply( opdata );
+	}
+	// for files the reply will be finished when the file has been written on disk (see onCacheWriteFinished)
 	return;
 }
 
-void QParse::processOperationsQueue() {
-	if ( operationsQueue.isEmpty() ) return;
-	OperationData* data = operationsQueue.dequeue();
+void QParse::processOperationsQueue( QParseDispatcher* dispatcher, OperationData* data ) {
+	QPARSE_TRACE( "dispatch", 'n', data->parseReply );
+	if ( data->dispatchedAt < 0 ) {
+		data->dispatchedAt = data->submittedTimer.nsecsElapsed();
+		recordStage( data, "queueWait", 0, data->dispatchedAt );
+	}
 	// create the endpoint
 	QUrl endpoint;
-	QString urlPrefix = "https://api.parse.com/1";
+	QString urlPrefix = getEndpoint("").toString( QUrl::StripTrailingSlash );
 	if ( data->parseRequest->getParseFile() && data->parseRequest->getParseFile()->isValid() ) {
 		// FILE ENDPOINT CREATION
 		if ( data->netMethod == QParse::OperationData::GET ) {
@@ -308,19 +956,22 @@ void QParse::processOperationsQueue() {
 	} else {
 		// NO FILE ENDPOINT CREATION
 		QString parseClassName = data->parseRequest->getParseClassName();
-		QParseObject* parseObject = data->parseRequest->getParseObject();
+		QString objectId = data->parseRequest->getObjectId();
 		if ( parseClassName == "_Users" ) {
 			endpoint = QUrl( QString("%1/users/%2")
 								.arg( urlPrefix )
-								.arg( parseObject ? parseObject->getObjectId() : "" ) );
+								.arg( objectId ) );
 		} else if (parseClassName == "login") {
 			endpoint = QUrl( QString("%1/login")
 								.arg( urlPrefix ) );
+		} else if (parseClassName == "batch") {
+			endpoint = QUrl( QString("%1/batch")
+								.arg( urlPrefix ) );
 		} else {
 			endpoint = QUrl( QString("%1/classes/%2/%3")
 								.arg( urlPrefix )
 								.arg( parseClassName )
-								.arg( parseObject ? parseObject->getObjectId() : "" ) );
+								.arg( objectId ) );
 		}
 		QList< QPair<QString,QString> > options = data->parseRequest->getOptions();
 		if ( options.size() > 0 ) {
@@ -330,39 +981,99 @@ void QParse::processOperationsQueue() {
 		}
 	}
 	// it only perform a network request if there is no cached data (or if it's invalid)
-	if ( data->parseRequest->getCacheControl() == QParse::AlwaysCache && isRequestCached(endpoint) ) {
+	// only get requests are served by the cache: the writes always go to PARSE
+	if ( data->netMethod == QParse::OperationData::GET && !data->skipCache &&
+		 data->parseRequest->getCacheControl() == QParse::AlwaysCache && isRequestCached(endpoint) ) {
 		// automatically reply with cached data
-		fillWithCachedData( endpoint, data->parseReply );
-		emit (data->parseReply->finished(data->parseReply));
+		fillWithCachedData( endpoint, data );
 	} else {
-		// create the netRequest
-		QNetworkRequest* request = new QNetworkRequest(endpoint);
-		request->setRawHeader("X-Parse-Application-Id", appId.toLatin1());
-		request->setRawHeader("X-Parse-REST-API-Key", restKey.toLatin1());
-		if ( user ) {
-			// if there is a user logged in, send also the session token
-			request->setRawHeader("X-Parse-Session-Token", user->getToken().toLatin1());
-		}
-		data->netRequest = request;
-		// send the net request to PARSE
-		QJsonDocument jsonDoc(data->dataToPost);
-		switch(data->netMethod) {
-		case QParse::OperationData::GET:
-			operationsPending[net->get( *request )] = data;
-		break;
-		case QParse::OperationData::POST:
-			request->setRawHeader("Content-Type", "application/json");
-			operationsPending[net->post( *request, jsonDoc.toJson(QJsonDocument::Compact) )] = data;
-		break;
-		case QParse::OperationData::PUT:
-			request->setRawHeader("Content-Type", "application/json");
-			operationsPending[net->post( *request, jsonDoc.toJson(QJsonDocument::Compact) )] = data;
-		break;
+		if ( data->netMethod == QParse::OperationData::GET && data->parseRequest->getCacheControl() == QParse::AlwaysCache ) {
+			stats->recordCacheMiss();
 		}
+		// create the netRequest, it will be sent when the throttle allows it
+		delete data->netRequest;
+		data->netRequest = new QNetworkRequest( createNetworkRequest(endpoint) );
+		dispatcher->send( data );
 	}
 	return;
 }
 
+void QParse::sendNetworkRequest( QParseDispatcher* dispatcher, OperationData* data ) {
+	QNetworkRequest* request = data->netRequest;
+	data->sentTimer.start();
+	data->sentAt = data->submittedTimer.nsecsElapsed();
+	QPARSE_TRACE( "send", 'n', data->parseReply );
+	data->firstByteAt = -1;
+	recordStage( data, "throttleWait", data->dispatchedAt, data->sentAt );
+	statsRequests.ref();
+	// prepare the body of post and put
+	QByteArray body;
+	if ( data->netMethod == QParse::OperationData::POST || data->netMethod == QParse::OperationData::PUT ) {
+		request->setRawHeader("Content-Type", "application/json");
+		body = QJsonDocument(data->dataToPost).toJson(QJsonDocument::Compact);
+		if ( capture.isOpen() ) {
+			data->sentBody = body;
+		}
+		QMutexLocker locker( &mutex );
+		bool compress = requestCompression && body.size() >= requestCompressionThreshold;
+		locker.unlock();
+		if ( compress ) {
+			QByteArray compressed = gzipCompress( body );
+			if ( compressed.size() < body.size() ) {
+				int saved = body.size() - compressed.size();
+				data->parseReply->setBytesSaved( saved );
+				statsRequestBytesSaved.fetchAndAddOrdered( saved );
+				request->setRawHeader("Content-Encoding", "gzip");
+				body = compressed;
+			}
+		}
+	}
+	// send the net request to PARSE
+	QNetworkReply* netReply = dispatcher->getTransport()->send( netMethodNames[data->netMethod], *request, body );
+	dispatcher->operationsPending[netReply] = data;
+	// the headers of the reply are the first bytes received
+	connect( netReply, &QNetworkReply::metaDataChanged, netReply, [data]() {
+		if ( data->firstByteAt < 0 ) {
+			data->firstByteAt = data->submittedTimer.nsecsElapsed();
+		}
+	});
+}
+
+QNetworkRequest QParse::createNetworkRequest( QUrl endpoint ) {
+	QMutexLocker locker( &mutex );
+	QNetworkRequest request(endpoint);
+	request.setRawHeader("X-Parse-Application-Id", appId.toLatin1());
+	request.setRawHeader("X-Parse-REST-API-Key", restKey.toLatin1());
+	// HTTP/2 is negotiated with the server, so it falls back to HTTP/1.1 when not supported
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+	request.setAttribute( QNetworkRequest::Http2AllowedAttribute, http2Allowed );
+#elif QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+	request.setAttribute( QNetworkRequest::HTTP2AllowedAttribute, http2Allowed );
+#endif
+	if ( user ) {
+		// if there is a user logged in, send also the session token
+		request.setRawHeader("X-Parse-Session-Token", user->getToken().toLatin1());
+	}
+	return request;
+}
+
+void QParse::finishReply( OperationData* opdata ) {
+	QParseReply* reply = opdata->parseReply;
+	QPARSE_TRACE( "request", 'e', reply );
+	// nothing to abort anymore
+	reply->client.storeRelease( NULL );
+	recordStage( opdata, "total", 0, opdata->submittedTimer.nsecsElapsed() );
+	stats->recordRequest( opdata->statsEndpoint, reply->getHasError() );
+	if ( reply->thread() == QThread::currentThread() ) {
+		emit (reply->finished(reply));
+	} else {
+		// deliver the reply on the thread that submitted the request
+		QMetaObject::invokeMethod( reply, "finished", Qt::QueuedConnection, Q_ARG(QParseReply*, reply) );
+	}
+	// the operation ends here, the reply is deleted by who handles it
+	delete opdata;
+}
+
 void QParse::loadCacheInfoData() {
 	// bundled parse cache director
 #if defined(Q_OS_IOS)
@@ -371,52 +1082,58 @@ void QParse::loadCacheInfoData() {
 	// suppose Android
 	QString bundleCacheDir = "assets:/parsecache";
 #endif
-
-	if ( !QFile::exists(cacheDir+"/"+cacheIni) && QFile::exists(bundleCacheDir+"/"+cacheIni) ) {
-		qDebug() << "COPYING BUNDLE CACHE INI TO LOCAL CACHE INI";
-		// first time here, take data from bundled parsecache
-		QSettings bundleSets( bundleCacheDir+"/"+cacheIni, QSettings::IniFormat, this );
-		QSettings cacheSets( cacheDir+"/"+cacheIni, QSettings::IniFormat, this );
-		bundleSets.setIniCodec("UTF-8");
-		cacheSets.setIniCodec("UTF-8");
-		int size = bundleSets.beginReadArray("caches");
-		cacheSets.beginWriteArray("caches");
-		QStringList props;
-		props << "url" << "createdAt" << "isJson" << "localFile";
-		for( int i=0; i<size; i++ ) {
-			bundleSets.setArrayIndex(i);
-			cacheSets.setArrayIndex(i);
-			foreach( QString prop, props ) {
-				cacheSets.setValue(prop, bundleSets.value(prop));
-			}
-			cacheSets.setValue("bundled", true);
-		}
-		bundleSets.endArray();
-		cacheSets.endArray();
-		cacheSets.sync();
+	if ( !cacheNamespace.isEmpty() ) {
+		bundleCacheDir += "/"+cacheNamespace;
 	}
+	// the index will be loaded on the worker and handled on onCacheIndexLoaded
+	QMetaObject::invokeMethod( cacheWorker, "loadIndex", Qt::QueuedConnection,
+							   Q_ARG(QString, cacheDir),
+							   Q_ARG(QString, cacheIni),
+							   Q_ARG(QString, bundleCacheDir) );
+}
 
-	QSettings cacheSets( cacheDir+"/"+cacheIni, QSettings::IniFormat, this );
-	cacheSets.setIniCodec("UTF-8");
-	int size = cacheSets.beginReadArray("caches");
-	for( int i=0; i<size; i++ ) {
-		cacheSets.setArrayIndex(i);
-		QUrl url = cacheSets.value("url").toUrl();
+void QParse::onCacheIndexLoaded( QVariantList entries, qint64 loadingTime ) {
+	startupTimings["indexLoadingTime"] = loadingTime;
+	startupTimings["indexEntries"] = entries.size();
+	QWriteLocker locker( &cacheLock );
+	foreach( QVariant entry, entries ) {
+		QVariantMap props = entry.toMap();
+		QUrl url = props["url"].toUrl();
 		CacheData cacheData;
-		cacheData.isJson = cacheSets.value("isJson").toBool();
-		cacheData.bundled = cacheSets.value("bundled").toBool();
-		if ( cacheData.bundled ) {
-			cacheData.localFile = QUrl::fromLocalFile(bundleCacheDir+"/"+cacheSets.value("localFile").toString());
-		} else {
-			cacheData.localFile = QUrl::fromLocalFile( cacheDir+"/"+cacheSets.value("localFile").toString() );
+		cacheData.isJson = props["isJson"].toBool();
+		cacheData.bundled = props["bundled"].toBool();
+		cacheData.packed = props["packed"].toBool();
+		cacheData.localFile = QUrl::fromLocalFile( props["localFile"].toString() );
+		cacheData.createdAt = props["createdAt"].toDateTime();
+		cacheData.codec = props["codec"].toString();
+		if ( !cacheData.bundled ) {
+			retainCacheBlob( cacheData.localFile.toLocalFile() );
+		}
+		// loading the index again replaces the entries already in the cache
+		if ( cache.contains(url) && !cache[url].bundled ) {
+			releaseCacheBlob( cache[url].localFile.toLocalFile() );
 		}
-		cacheData.createdAt = cacheSets.value("createdAt").toDateTime();
 		cache[url] = cacheData;
 	}
-	cacheSets.endArray();
+	locker.unlock();
+	traceStartup( "ready" );
+	ready.storeRelease( 1 );
+	if ( pendingConfigPull ) {
+		pendingConfigPull = false;
+		pullAppConfigValues( pendingConfigForceNetwork );
+		pendingConfigForceNetwork = false;
+	}
+	// the dispatchers will process the requests held so far
+	emit readyChanged( true );
 }
 
-void QParse::updateCache( QNetworkReply* reply, QParse::OperationData* opdata ) {
+void QParse::traceStartup( QString mark ) {
+	startupTimings[mark] = startupTimer.elapsed();
+	qparseDebug( qparseCache ) << "startup" << mark << startupTimer.elapsed() << "ms";
+}
+
+void QParse::updateCache( QUrl url, QByteArray data, QParse::OperationData* opdata ) {
+	QParseTraceScope trace( "updateCache" );
 	CacheData cacheData;
 	// !! opdata is NULL when QParse call this method for caching Parse App config
 	if ( !opdata ) {
@@ -425,126 +1142,260 @@ void QParse::updateCache( QNetworkReply* reply, QParse::OperationData* opdata )
 		cacheData.isJson = opdata->parseReply->getIsJson();
 	}
 	cacheData.createdAt = QDateTime::currentDateTime();
-	QString cacheFilename;
-	if ( cacheData.isJson ) {
-		if ( cache.contains(reply->url()) && !cache[reply->url()].bundled ) {
-			// use the same file again
-			cacheFilename = cache[reply->url()].localFile.toLocalFile();
-		} else {
-			cacheFilename = getUniqueCacheFilename();
-		}
-	} else {
-		cacheFilename = cacheDir+"/"+opdata->parseRequest->getParseFile()->getName();
+	// only Json data are compressed; files (images, etc) are mostly already compressed
+	if ( cacheData.isJson && cacheCompression && data.size() >= cacheCompressionThreshold ) {
+		cacheData.codec = "zlib";
 	}
-	QFile cacheFile( cacheFilename );
-	if ( !cacheFile.open( QIODevice::WriteOnly | QIODevice::Truncate ) ) {
-		qDebug() << "Destination" << cacheFilename;
-		qFatal( "Cannot write on cache directory !!" );
+	// the data is stored by content, so equal data from different urls share the same file
+	QString cacheFilename = getCacheBlobFilename( data, cacheData, opdata );
+	if ( !cacheData.isJson ) {
+		// the reply will be finished as soon as the file is on disk
+		QMutexLocker pendingLocker( &mutex );
+		cacheWritesPending.insert( url, opdata );
 	}
-	cacheFile.write( reply->readAll() );
-	cacheFile.flush();
-	cacheFile.close();
+	QWriteLocker locker( &cacheLock );
+	retainCacheBlob( cacheFilename );
+	if ( cache.contains(url) && !cache[url].bundled ) {
+		releaseCacheBlob( cache[url].localFile.toLocalFile() );
+	}
+	// if the file already exists, the worker does not write it again
+	// Json data can wait on the queue of the worker, files are needed as soon as possible
+	QMetaObject::invokeMethod( cacheWorker, "writeBlob", Qt::QueuedConnection,
+							   Q_ARG(QUrl, url),
+							   Q_ARG(QString, cacheFilename),
+							   Q_ARG(QByteArray, data),
+							   Q_ARG(QString, cacheData.codec),
+							   Q_ARG(bool, cacheData.isJson) );
 	cacheData.localFile = QUrl::fromLocalFile( cacheFilename );
 	cacheData.bundled = false;
-	cache[reply->url()] = cacheData;
-	// write down on settings on disk
-	QSettings cacheSets( cacheDir+"/"+cacheIni, QSettings::IniFormat, this );
-	cacheSets.setIniCodec("UTF-8");
-	cacheSets.beginWriteArray("caches");
-	int pos = 0;
+	cache[url] = cacheData;
+	saveCacheInfoData();
+}
+
+void QParse::removeCacheEntry( QUrl url ) {
+	QWriteLocker locker( &cacheLock );
+	if ( !cache.contains(url) ) return;
+	CacheData cacheData = cache.take( url );
+	if ( !cacheData.bundled ) {
+		releaseCacheBlob( cacheData.localFile.toLocalFile() );
+	}
+	saveCacheInfoData();
+}
+
+void QParse::saveCacheInfoData() {
+	// the worker will write down on settings on disk
+	QVariantList entries;
 	foreach( QUrl url, cache.keys() ) {
 		CacheData cachep = cache[url];
-		cacheSets.setArrayIndex(pos);
-		cacheSets.setValue("url", url);
-		cacheSets.setValue("isJson", cachep.isJson);
-		cacheSets.setValue("localFile", cachep.localFile.fileName());
-		cacheSets.setValue("createdAt", cachep.createdAt);
-		cacheSets.setValue("bundled", cachep.bundled);
-		pos++;
+		// packed entries are always loaded from the bundled pack
+		if ( cachep.packed ) continue;
+		QVariantMap entry;
+		entry["url"] = url;
+		entry["isJson"] = cachep.isJson;
+		entry["localFile"] = cachep.localFile.fileName();
+		entry["createdAt"] = cachep.createdAt;
+		entry["bundled"] = cachep.bundled;
+		entry["codec"] = cachep.codec;
+		entries << entry;
 	}
-	cacheSets.endArray();
+	QMetaObject::invokeMethod( cacheWorker, "writeIndex", Qt::QueuedConnection,
+							   Q_ARG(QString, cacheDir+"/"+cacheIni),
+							   Q_ARG(QVariantList, entries) );
 }
 
 bool QParse::isRequestCached( QUrl url ) {
+	QReadLocker locker( &cacheLock );
 	return cache.contains(url);
 }
 
 QUrl QParse::getCachedUrlOf( QUrl remoteFile ) {
+	QReadLocker locker( &cacheLock );
 	if ( cache.contains(remoteFile) ) {
 		CacheData cacheData = cache[remoteFile];
+		// packed files are not local until they are extracted
+		if ( cacheData.packed ) return QUrl();
 		return cacheData.localFile;
 	}
 	return QUrl();
 }
 
-void QParse::fillWithCachedData( QUrl url, QParseReply* reply ) {
-	CacheData cacheData = cache[url];
-	if ( reply->getIsJson() ) {
-		QFile cacheFile( cacheData.localFile.toLocalFile() );
-		if ( !cacheFile.open( QIODevice::ReadOnly ) ) {
-			qFatal( "Cannot read on cache directory !!");
-		}
-		QJsonObject json = QJsonDocument::fromJson( cacheFile.readAll() ).object();
-		cacheFile.close();
-		reply->setJson( json );
+void QParse::fillWithCachedData( QUrl url, QParse::OperationData* opdata ) {
+	QParseTraceScope trace( "fillWithCachedData" );
+	QReadLocker locker( &cacheLock );
+	CacheData cacheData = cache.value(url);
+	locker.unlock();
+	stats->recordCacheHit( cacheData.packed ? "pack" : (cacheData.bundled ? "bundled" : "disk") );
+	if ( opdata->parseReply->getIsJson() ) {
+		// the reply will be finished when data has been read (see onCacheReadFinished)
+		QMutexLocker pendingLocker( &mutex );
+		cacheReadsPending.insert( url, opdata );
+		pendingLocker.unlock();
+		readCachedData( url );
+	} else if ( cacheData.packed ) {
+		// the reply will be finished when the file has been extracted (see onCacheWriteFinished)
+		QMutexLocker pendingLocker( &mutex );
+		cacheWritesPending.insert( url, opdata );
+		pendingLocker.unlock();
+		QMetaObject::invokeMethod( cacheWorker, "extractPacked", Qt::QueuedConnection,
+								   Q_ARG(QUrl, url),
+								   Q_ARG(QString, cacheData.localFile.toLocalFile()) );
 	} else {
-		reply->setLocalUrl( cacheData.localFile );
+		opdata->parseReply->setLocalUrl( cacheData.localFile );
+		finishReply( opdata );
 	}
 }
 
-QJsonObject QParse::getCachedJson( QUrl url ) {
-	CacheData cacheData = cache[url];
-	QFile cacheFile( cacheData.localFile.toLocalFile() );
-	if ( !cacheFile.open( QIODevice::ReadOnly ) ) {
-		qDebug() << "LOCATION: " << cacheData.localFile << cacheData.localFile.toLocalFile() << cacheDir;
-		qFatal( "Cannot read on cache directory !!");
+void QParse::readCachedData( QUrl url ) {
+	QReadLocker locker( &cacheLock );
+	CacheData cacheData = cache.value(url);
+	locker.unlock();
+	if ( cacheData.packed ) {
+		QMetaObject::invokeMethod( cacheWorker, "readPacked", Qt::QueuedConnection,
+								   Q_ARG(QUrl, url) );
+		return;
+	}
+	QMetaObject::invokeMethod( cacheWorker, "read", Qt::QueuedConnection,
+							   Q_ARG(QUrl, url),
+							   Q_ARG(QString, cacheData.localFile.toLocalFile()),
+							   Q_ARG(QString, cacheData.codec) );
+}
+
+void QParse::onCacheReadFinished( QUrl key, QByteArray data, bool ok ) {
+	if ( !ok ) {
+		// the cached data is not valid anymore, so it's like it was never cached
+		removeCacheEntry( key );
+	}
+	// check the special case of PARSE App Config
+	if ( key == getEndpoint("config") ) {
+		if ( ok ) {
+			updateAppConfig( data );
+		} else {
+			pullAppConfigValues( true );
+		}
+	}
+	QMutexLocker pendingLocker( &mutex );
+	QList<OperationData*> waiting = cacheReadsPending.values( key );
+	cacheReadsPending.remove( key );
+	pendingLocker.unlock();
+	foreach( OperationData* opdata, waiting ) {
+		if ( ok ) {
+			qint64 parseStart = opdata->submittedTimer.nsecsElapsed();
+			opdata->parseReply->setJson( jsonFromReplyData( data ) );
+			recordStage( opdata, "jsonParse", parseStart, opdata->submittedTimer.nsecsElapsed() );
+			finishReply( opdata );
+		} else {
+			// cache miss, so send the request over the network
+			opdata->skipCache = true;
+			enqueueOn( opdata );
+		}
+	}
+}
+
+void QParse::onCacheWriteFinished( QUrl key, QString filename, bool ok ) {
+	QWriteLocker locker( &cacheLock );
+	bool isEntryFile = cache.contains(key) && cache[key].localFile == QUrl::fromLocalFile(filename);
+	if ( ok && isEntryFile && cache[key].packed ) {
+		// the file has been extracted from the pack, from now it's a normal cached file
+		cache[key].packed = false;
+		cache[key].bundled = false;
+		retainCacheBlob( filename );
+		saveCacheInfoData();
+	}
+	locker.unlock();
+	if ( !ok && isEntryFile ) {
+		// the data is not on disk, so it's not cached at all
+		removeCacheEntry( key );
+	}
+	QMutexLocker pendingLocker( &mutex );
+	QList<OperationData*> waiting = cacheWritesPending.values( key );
+	cacheWritesPending.remove( key );
+	pendingLocker.unlock();
+	foreach( OperationData* opdata, waiting ) {
+		if ( ok ) {
+			opdata->parseReply->setLocalUrl( QUrl::fromLocalFile(filename) );
+		} else {
+			opdata->parseReply->setHasError( true );
+			opdata->parseReply->setErrorMessage( "Cannot write on cache directory" );
+		}
+		finishReply( opdata );
+	}
+}
+
+void QParse::updateAppConfig( QByteArray rawData ) {
+	QJsonObject data = QJsonDocument::fromJson( rawData ).object();
+	if ( data.contains("params") ) {
+		appConfig = data["params"].toObject();
+		emit appConfigChanged();
 	}
-	QJsonObject json = QJsonDocument::fromJson( cacheFile.readAll() ).object();
-	cacheFile.close();
-	return json;
 }
 
 void QParse::saveInstallation() {
 	// if objectId is not present, the installation object is not valid
 	if ( !installation.contains("objectId") ) return;
 	// save on the installation.json
-	QFile cacheFile( cacheDir+"/installation.json" );
-	if ( !cacheFile.open( QIODevice::WriteOnly | QIODevice::Truncate ) ) {
-		qDebug() << "Destination" << (cacheDir+"/installation.json");
-		qFatal( "Cannot write on cache directory !!" );
-	}
-	QJsonDocument jsonDoc( installation );
-	cacheFile.write( jsonDoc.toJson(QJsonDocument::Compact) );
-	cacheFile.flush();
-	cacheFile.close();
+	QString installationFile = cacheDir+"/installation.json";
+	// the changes not pushed yet are stored together with the installation
+	QJsonObject installationData = installation;
+	if ( !installationChangedKeys.isEmpty() ) {
+		installationData["_changedKeys"] = QJsonArray::fromStringList( installationChangedKeys );
+	}
+	QJsonDocument jsonDoc( installationData );
+	QMetaObject::invokeMethod( cacheWorker, "write", Qt::QueuedConnection,
+							   Q_ARG(QUrl, QUrl::fromLocalFile(installationFile)),
+							   Q_ARG(QString, installationFile),
+							   Q_ARG(QByteArray, jsonDoc.toJson(QJsonDocument::Compact)),
+							   Q_ARG(QString, QString()),
+							   Q_ARG(bool, true) );
 }
 
 void QParse::loadInstallation() {
 	QString installationFile = cacheDir+"/installation.json";
 	if ( !QFile::exists(installationFile) ) return;
-	// load the installation on cache disk
+	// it's tiny, and createInstallation needs it at startup for not creating a new installation row
 	QFile cacheFile( installationFile );
 	if ( !cacheFile.open( QIODevice::ReadOnly ) ) {
-		qFatal( "Cannot read on cache directory !!");
+		qparseWarning( qparseInstallation ) << "cannot read" << installationFile;
+		return;
 	}
 	installation = QJsonDocument::fromJson( cacheFile.readAll() ).object();
 	cacheFile.close();
+	foreach( QJsonValue key, installation.take("_changedKeys").toArray() ) {
+		installationChangedKeys.append( key.toString() );
+	}
+	if ( !installationChangedKeys.isEmpty() ) {
+		// the changes not pushed before quitting are sent when the client is running
+		QTimer::singleShot( 0, this, [this]() {
+			pushInstallation();
+		});
+	}
 }
 
-QString QParse::getUniqueCacheFilename() {
-	int lenght = 8;
-	while( true ) {
-		QString str;
-		for( int i=0; i<lenght; i++ ) {
-			str.append( QChar(97+qrand()%25) );
-		}
-		// !!! Reserved name of installation.json
-		if ( str == QString("installation.json") ) {
-			continue;
-		}
-		str = QString("%1/%2.json").arg(cacheDir).arg(str);
-		if ( !QFile::exists(str) ) {
-			return str;
+QString QParse::getCacheBlobFilename( QByteArray data, const CacheData& cacheData, OperationData* opdata ) {
+	QString hash = QString::fromLatin1( QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex() );
+	if ( cacheData.isJson ) {
+		// the codec is part of the name, so the same data stored compressed and raw never collide
+		if ( cacheData.codec.isEmpty() ) {
+			return QString("%1/%2.json").arg(cacheDir).arg(hash);
 		}
+		return QString("%1/%2.json.%3").arg(cacheDir).arg(hash).arg(cacheData.codec);
+	}
+	// keep the extension of the file, it's used for detecting the file type by who is using it
+	QString suffix = QFileInfo( opdata->parseRequest->getParseFile()->getName() ).suffix();
+	if ( suffix.isEmpty() ) {
+		return QString("%1/%2").arg(cacheDir).arg(hash);
 	}
+	return QString("%1/%2.%3").arg(cacheDir).arg(hash).arg(suffix);
+}
+
+void QParse::retainCacheBlob( QString filename ) {
+	cacheBlobRefs[filename]++;
+}
+
+void QParse::releaseCacheBlob( QString filename ) {
+	if ( !cacheBlobRefs.contains(filename) ) return;
+	if ( --cacheBlobRefs[filename] > 0 ) return;
+	// no more entries in the cache refer to this file
+	cacheBlobRefs.remove( filename );
+	QMetaObject::invokeMethod( cacheWorker, "remove", Qt::QueuedConnection,
+							   Q_ARG(QString, filename) );
 }
@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QMap>
+#include <QHash>
 #include <QList>
 #include <QPair>
 #include <QStringList>
@@ -14,55 +15,234 @@
 #include <QJsonValue>
 #include <QVariantMap>
 #include <QTimer>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QAtomicInt>
 #include <QNetworkDiskCache>
+#include <QNetworkAccessManager>
 #include <QQmlNetworkAccessManagerFactory>
+#include <QFuture>
+#include "qparsecapture.h"
 
-class QNetworkAccessManager;
 class QNetworkRequest;
 class QNetworkReply;
 class OperationData;
 class QFile;
 class QParseRequest;
 class QParseReply;
+class QParseResult;
 class QParseObject;
 class QParseUser;
 class QParseDiskCache;
+class QParseDiskCacheStore;
+class QParseCacheWorker;
+class QParseDispatcher;
+class QParseOutbox;
+class QParseThrottle;
+class QParseStats;
+class QThread;
 class QParseNetworkAccessManagerFactory;
+class QParseTransportFactory;
 
 /*! This class creates allow to connect to PARSE cloud and
  *  perform operations on it as query, storing and retriveing data
  *
- *  This object is a singleton
+ *  The singleton instance() is the default client used by all QParse classes;
+ *  other independent clients (for other PARSE apps) can be created with their
+ *  own base url, keys, user, connections and cache namespace
  *
  *  Now, it use REST API of PARSE
+ *
+ *  Requests can be submitted (get, post, put) from any thread: each thread
+ *  has its own network manager, and the QParseReply is delivered on the
+ *  thread that submitted the request
+ *
+ *  The threads not running an event loop (like the ones of QThreadPool and QtConcurrent)
+ *  could never process a request nor receive its reply: their requests are dispatched on
+ *  the network thread, and their QParseReply is moved there and finished there; use
+ *  getAsync and wait the future from those threads
+ *
+ *  \warning the first call to instance() must be done from the main thread,
+ *            and the methods about installation, app config and user are
+ *            for the main thread only
  */
 class QParse : public QObject {
 	Q_OBJECT
+	//! the url prefix of all PARSE REST endpoints
+	Q_PROPERTY( QUrl baseUrl READ getBaseUrl WRITE setBaseUrl NOTIFY baseUrlChanged )
 	//! PARSE Application ID
 	Q_PROPERTY( QString appId MEMBER appId NOTIFY appIdChanged )
 	//! PARSE REST API Key (use the client key, not the master)
 	Q_PROPERTY( QString restKey MEMBER restKey NOTIFY restKeyChanged )
 	//! this allow to bind the logged user to QML properties
 	Q_PROPERTY( QParseUser* me READ getMe NOTIFY meChanged )
+	//! if true the Json data stored into the cache will be compressed
+	Q_PROPERTY( bool cacheCompression READ getCacheCompression WRITE setCacheCompression NOTIFY cacheCompressionChanged )
+	//! the minimum size in bytes of a Json data to be compressed into the cache
+	Q_PROPERTY( int cacheCompressionThreshold READ getCacheCompressionThreshold WRITE setCacheCompressionThreshold NOTIFY cacheCompressionThresholdChanged )
+	/*! true when the cache index has been loaded
+	 *  Requests submitted before are held, and they will be processed as soon as it's ready
+	 */
+	Q_PROPERTY( bool ready READ isReady NOTIFY readyChanged )
+	/*! if true all requests are sent and their replies processed (Json parsing, caching)
+	 *  on a dedicated network thread; only the QParseReply::finished signal is delivered
+	 *  on the thread that submitted the request
+	 *  \note it applies to requests submitted after the change; installation and app config
+	 *         requests always use the QParse thread
+	 */
+	Q_PROPERTY( bool useNetworkThread READ getUseNetworkThread WRITE setUseNetworkThread NOTIFY useNetworkThreadChanged )
+	/*! if true QParseObject::save commits the object into the outbox on disk and returns at once;
+	 *  the outbox sends the writes to PARSE when the network is accessible (see QParseOutbox)
+	 */
+	Q_PROPERTY( bool offlineWrites READ getOfflineWrites WRITE setOfflineWrites NOTIFY offlineWritesChanged )
+	//! the queue of the writes not sent to PARSE yet
+	Q_PROPERTY( QParseOutbox* outbox READ getOutbox CONSTANT )
+	/*! the maximum number of requests per second sent to PARSE; 0, the default, means no limit
+	 *  Set it to the quota of the PARSE app (30 by default on PARSE) so the requests over it
+	 *  wait on the client instead of being refused (see QParseThrottle)
+	 */
+	Q_PROPERTY( double requestRateLimit READ getRequestRateLimit WRITE setRequestRateLimit NOTIFY requestRateLimitChanged )
+	/*! if true, the connections to PARSE are opened (DNS, TCP and TLS) as soon as the keys are set,
+	 *  so the first request does not wait for them
+	 */
+	Q_PROPERTY( bool prewarmConnections READ getPrewarmConnections WRITE setPrewarmConnections NOTIFY prewarmConnectionsChanged )
+	/*! the maximum number of requests in flight of the client; with HTTP/1.1 Qt uses
+	 *  at most 6 connections for each host, with HTTP/2 they are multiplexed on one connection
+	 */
+	Q_PROPERTY( int connectionPoolSize READ getConnectionPoolSize WRITE setConnectionPoolSize NOTIFY connectionPoolSizeChanged )
+	/*! if true the Json bodies of post and put requests bigger than requestCompressionThreshold
+	 *  are sent compressed with gzip (Content-Encoding: gzip); the server must support it
+	 *  \note the replies are always requested compressed, and Qt decompresses them while receiving
+	 */
+	Q_PROPERTY( bool requestCompression READ getRequestCompression WRITE setRequestCompression NOTIFY requestCompressionChanged )
+	//! the minimum size in bytes of the compressed request bodies
+	Q_PROPERTY( int requestCompressionThreshold READ getRequestCompressionThreshold WRITE setRequestCompressionThreshold NOTIFY requestCompressionThresholdChanged )
+	//! if true HTTP/2 is used when the server supports it (it requires Qt 5.8)
+	Q_PROPERTY( bool http2Allowed READ getHttp2Allowed WRITE setHttp2Allowed NOTIFY http2AllowedChanged )
+	//! the timings of the requests and the usage of the cache
+	Q_PROPERTY( QParseStats* stats READ getStats CONSTANT )
+	/*! if not empty, all the requests sent to PARSE and their replies are recorded on this file,
+	 *  without the credentials, for replaying them with QParseReplay (see QParseCapture)
+	 */
+	Q_PROPERTY( QString captureFile READ getCaptureFile WRITE setCaptureFile NOTIFY captureFileChanged )
+	/*! the maximum size in bytes of the HTTP cache shared by the network managers
+	 *  using a QParseDiskCache of this client; the default is 50 MB
+	 */
+	Q_PROPERTY( qint64 httpCacheSize READ getHttpCacheSize WRITE setHttpCacheSize NOTIFY httpCacheSizeChanged )
 public:
 	//! used by QParseRequest and QParseQuery to set the desider cache behavior
 	enum CacheControl { AlwaysCache, AlwaysNetwork };
 	Q_ENUM( CacheControl )
+	/*! create an independent client
+	 *  \param cacheNamespace the name of the sub-directory of the cache (and of the bundled cache)
+	 *         used by this client; it must be unique for each client; the singleton uses an empty one
+	 *  \note the threads for network and cache I/O are shared by all clients
+	 */
+	explicit QParse( QString cacheNamespace, QObject* parent=0 );
+	/*! the requests not finished yet are finished with QNetworkReply::OperationCanceledError,
+	 *  the pending data of the cache is written down by the worker, and the dispatchers
+	 *  of all the threads are released
+	 */
+	~QParse();
 	//! return the singleton instance of CloudInterface
 	static QParse* instance();
+	/*! \internal return the client (or the QParse singleton if NULL) if called from its thread, NULL otherwise
+	 *  It's the parent to use for objects created by QParse classes, because
+	 *  an object cannot have a parent living on another thread
+	 */
+	static QObject* parentForCurrentThread( QParse* parse=NULL );
+	//! return the url of the endpoint at path, using the baseUrl of the client
+	QUrl getEndpoint( QString path ) const;
 #ifdef Q_OS_IOS
 	//! \internal create and send a request for registering the device token
 	void sendInstallationPostRequest( QString token );
 #endif
 	//! \internal return (if cached) the local Url of the file; return empty if not cached
 	QUrl getCachedUrlOf( QUrl remoteFile );
+	//! \internal return the entries of the HTTP cache shared by the QParseDiskCache of this client
+	QParseDiskCacheStore* getHttpCache() const;
+	/*! set the factory of the network managers used for sending the requests
+	 *  (like QQmlEngine, the factory has to be thread-safe because it's called from the threads
+	 *  of the dispatchers); NULL, the default, means a plain QNetworkAccessManager
+	 *  \note it applies to the dispatchers created after the call, so set it before creating the client
+	 *  \note the ownership of the factory is not taken
+	 */
+	static void setNetworkAccessManagerFactory( QQmlNetworkAccessManagerFactory* factory );
+	static QQmlNetworkAccessManagerFactory* getNetworkAccessManagerFactory();
+	/*! set the factory of the transports sending the requests of the dispatchers
+	 *  (see QParseTransport); NULL, the default, means the network of the dispatcher
+	 *  \note it applies to the dispatchers created after the call, so set it before creating the client
+	 *  \note the requests of the installation and of the app config always go on the network
+	 *  \note the ownership of the factory is not taken
+	 */
+	static void setTransportFactory( QParseTransportFactory* factory );
+	static QParseTransportFactory* getTransportFactory();
+	/*! Perform a get request on PARSE and return the future of its result
+	 *  (not a slot: QParseResult is only declared here, and futures are not usable from QML)
+	 *  The future is finished on the calling thread, and the QParseReply is deleted automatically
+	 *  \note use qParseThen and qParseWhenAll (qparsefuture.h) to compose futures
+	 */
+	QFuture<QParseResult> getAsync( QParseRequest* request );
+	//! Perform a post request on PARSE and return the future of its result (see getAsync)
+	QFuture<QParseResult> postAsync( QParseRequest* request );
+	//! Perform a put request on PARSE and return the future of its result (see getAsync)
+	QFuture<QParseResult> putAsync( QParseRequest* request );
 public slots:
+	QUrl getBaseUrl() const;
+	void setBaseUrl( const QUrl& value );
+	//! the namespace of the cache of this client
+	QString getCacheNamespace() const;
+	bool isReady() const;
+	/*! return the milliseconds elapsed from the construction of QParse to each startup stage
+	 *  ("constructed", "ready") plus the time spent by the worker for loading the cache index
+	 */
+	QVariantMap getStartupTimings() const;
 	QString getAppId() const;
 	void setAppId(const QString &value);
 	QString getRestKey() const;
 	void setRestKey(const QString &value);
 	QString getGCMSenderId();
 	void setGCMSenderId(const QString& value);
+	bool getCacheCompression() const;
+	void setCacheCompression( bool value );
+	int getCacheCompressionThreshold() const;
+	void setCacheCompressionThreshold( int value );
+	bool getUseNetworkThread() const;
+	void setUseNetworkThread( bool value );
+	bool getOfflineWrites() const;
+	void setOfflineWrites( bool value );
+	QParseOutbox* getOutbox() const;
+	double getRequestRateLimit() const;
+	void setRequestRateLimit( double value );
+	//! return the current limit of the requests in flight, adapted to the latency of PARSE
+	int getConcurrencyLimit() const;
+	bool getPrewarmConnections() const;
+	void setPrewarmConnections( bool value );
+	int getConnectionPoolSize() const;
+	void setConnectionPoolSize( int value );
+	bool getHttp2Allowed() const;
+	void setHttp2Allowed( bool value );
+	bool getRequestCompression() const;
+	void setRequestCompression( bool value );
+	int getRequestCompressionThreshold() const;
+	void setRequestCompressionThreshold( int value );
+	/*! return the statistics of the connections since the start or the last reset:
+	 *  requests: the network requests sent
+	 *  handshakes: the TLS handshakes done, that is the new connections opened
+	 *  reusedRequests: the requests sent on a connection already opened
+	 *  http2Requests: the requests done with HTTP/2
+	 *  firstRequestLatency: the milliseconds of the first request (-1 if not done yet)
+	 *  requestBytesSaved: the bytes of request bodies saved by requestCompression
+	 */
+	QVariantMap getConnectionStats() const;
+	void resetConnectionStats();
+	//! return the timings of the requests and the usage of the cache (see QParseStats)
+	QParseStats* getStats() const;
+	QString getCaptureFile() const;
+	qint64 getHttpCacheSize() const;
+	void setHttpCacheSize( qint64 value );
+	void setCaptureFile( QString value );
 	/*! return the Json value of the specified PARSE config
 	 *  \note before access to any app config, make sure you downloaded the app config
 	 *		  with updateAppConfigValues
@@ -108,30 +288,164 @@ public slots:
 
 	//! return the logged user; a NULL pointer means no user is logged in
 	QParseUser* getMe();
-	//! Perform a get request on PARSE
+	/*! Perform a get request on PARSE
+	 *  \note it's safe to call it from any thread; the returned QParseReply lives on the calling thread
+	 */
 	QParseReply* get( QParseRequest* request );
-	//! Perform a post request on PARSE
+	/*! Perform a post request on PARSE
+	 *  \note it's safe to call it from any thread; the returned QParseReply lives on the calling thread
+	 */
 	QParseReply* post( QParseRequest* request );
-	//! Perform a put request on PARSE
+	/*! Perform a put request on PARSE
+	 *  \note it's safe to call it from any thread; the returned QParseReply lives on the calling thread
+	 */
 	QParseReply* put( QParseRequest* request );
+	/*! Perform a delete request on PARSE
+	 *  \note it's safe to call it from any thread; the returned QParseReply lives on the calling thread
+	 */
+	QParseReply* deleteResource( QParseRequest* request );
 signals:
+	void baseUrlChanged( QUrl baseUrl );
 	void appIdChanged( QString appId );
 	void restKeyChanged( QString restKey );
 	//! emitted when the app config has been updated (retrieve them using getAppConfigValue
 	void appConfigChanged();
 	void meChanged( QParseUser* user );
+	void cacheCompressionChanged( bool cacheCompression );
+	void cacheCompressionThresholdChanged( int cacheCompressionThreshold );
+	void readyChanged( bool ready );
+	void useNetworkThreadChanged( bool useNetworkThread );
+	void offlineWritesChanged( bool offlineWrites );
+	void requestRateLimitChanged( double requestRateLimit );
+	void prewarmConnectionsChanged( bool prewarmConnections );
+	void connectionPoolSizeChanged( int connectionPoolSize );
+	void http2AllowedChanged( bool http2Allowed );
+	void requestCompressionChanged( bool requestCompression );
+	void requestCompressionThresholdChanged( int requestCompressionThreshold );
+	void captureFileChanged( QString captureFile );
+	void httpCacheSizeChanged( qint64 httpCacheSize );
 private slots:
-	//! it manage the returned data from the cloud backed
-	void onRequestFinished( QNetworkReply* reply );
+	//! it manage the data read from the cache by the cache worker
+	void onCacheReadFinished( QUrl key, QByteArray data, bool ok );
+	//! it manage the completion of a write on the cache by the cache worker
+	void onCacheWriteFinished( QUrl key, QString filename, bool ok );
+	//! it builds the cache from the index loaded by the cache worker
+	void onCacheIndexLoaded( QVariantList entries, qint64 loadingTime );
+	//! open the connections to PARSE in advance, if enabled and the keys are set
+	void prewarm();
+	//! push the installation changes made while the network was not accessible
+	void onNetworkAccessibleChanged( QNetworkAccessManager::NetworkAccessibility accessible );
 private:
-	// private constructor; this is a singleton
-	QParse(QObject *parent = 0);
 	Q_DISABLE_COPY( QParse )
+	friend class QParseDispatcher;
+	friend class QParseReply;
+	//! the micro-benchmarks (tests/qparsebench) measure the cache on its internal paths
+	friend class QParseBenchmark;
 
+	class OperationData;
 	/*! process a queued QParseRequest and create the corresponding
 	 *  QNetworkRequest to send over internet for the reply to PARSE
+	 *  \note it's called on the thread of the dispatcher
+	 */
+	void processOperationsQueue( QParseDispatcher* dispatcher, OperationData* data );
+	/*! send the network request of the operation to PARSE
+	 *  \note it's called on the thread of the dispatcher, when the throttle allows it
+	 */
+	void sendNetworkRequest( QParseDispatcher* dispatcher, OperationData* data );
+	/*! it manage the returned data from the cloud backed
+	 *  \note it's called on the thread of the dispatcher
+	 */
+	void onRequestFinished( QParseDispatcher* dispatcher, QNetworkReply* reply );
+	//! create the network request to PARSE for the endpoint with all the needed headers
+	QNetworkRequest createNetworkRequest( QUrl endpoint );
+	//! assign the operation to the dispatcher of the calling thread, and enqueue it
+	void enqueueOperation( OperationData* data );
+	/*! emit the finished signal of the reply on the thread where the reply lives
+	 *  \note the operation is deleted, don't use it after the call
+	 */
+	void finishReply( OperationData* opdata );
+	//! record the milliseconds elapsed between two stages of the operation (in nanoseconds since the submission)
+	void recordStage( OperationData* opdata, QString metric, qint64 from, qint64 to );
+	//! finish the reply of a cancelled operation with QNetworkReply::OperationCanceledError
+	void cancelOperation( OperationData* opdata );
+	/*! return a future finished when the reply is finished
+	 *  \warning call it before the operation is enqueued (see submitAsync)
+	 */
+	QFuture<QParseResult> toFuture( QParseReply* reply );
+
+	/*! the dispatchers of this client, one for each thread that submitted requests
+	 *  (and the one of the network thread); a dispatcher is deleted when its thread exits
 	 */
-	void processOperationsQueue();
+	QHash<QThread*, QParseDispatcher*> dispatchers;
+	//! protect dispatchers
+	QMutex dispatchersMutex;
+	//! return the dispatcher living on the thread; it's created if not exists yet
+	QParseDispatcher* getDispatcherOf( QThread* thread );
+	//! return the dispatcher of the calling thread; it's created if not exists yet
+	QParseDispatcher* getThreadDispatcher();
+	//! return the dispatcher to use for the requests submitted by the calling thread
+	QParseDispatcher* getDispatcher();
+	/*! enqueue the operation on its dispatcher, or on the one of the calling thread
+	 *  when the thread of its dispatcher exited
+	 */
+	void enqueueOn( OperationData* opdata );
+	//! ask to all the dispatchers to cancel the request of the reply (see QParseReply::abort)
+	void abortReply( QParseReply* reply );
+	//! true means all requests are dispatched by the dispatcher of the network thread
+	bool useNetworkThread;
+	//! limit the rate and the concurrency of the requests of all the dispatchers
+	QParseThrottle* throttle;
+	//! the timings of the requests of all the dispatchers
+	QParseStats* stats;
+	//! the HTTP cache of the QParseDiskCache of this client
+	QParseDiskCacheStore* httpCache;
+	//! true means the connections are opened when the keys are set
+	bool prewarmConnections;
+	//! true means HTTP/2 is allowed on the requests
+	bool http2Allowed;
+	//! true means the request bodies are compressed
+	bool requestCompression;
+	int requestCompressionThreshold;
+	//! statistics of the connections of all the dispatchers (see getConnectionStats)
+	QAtomicInt statsRequests;
+	QAtomicInt statsHandshakes;
+	QAtomicInt statsHttp2Requests;
+	QAtomicInt statsFirstRequestLatency;
+	QAtomicInt statsRequestBytesSaved;
+	//! true means QParseObject::save uses the outbox
+	bool offlineWrites;
+	//! the writes waiting to be sent to PARSE
+	QParseOutbox* outbox;
+	//! the file where the requests are recorded; empty means not recording
+	QString captureFile;
+	//! records the requests of all the dispatchers when captureFile is set
+	QParseCapture capture;
+	//! the factory of the network managers of the dispatchers
+	static QAtomicPointer<QQmlNetworkAccessManagerFactory> networkFactory;
+	//! the factory of the transports of the dispatchers
+	static QAtomicPointer<QParseTransportFactory> transportFactory;
+
+	//! protect the PARSE keys, the user and the operations waiting for the cache worker
+	mutable QMutex mutex;
+	//! protect the cache index (cache and cacheBlobRefs)
+	mutable QReadWriteLock cacheLock;
+
+	//! true when the cache index has been loaded
+	QAtomicInt ready;
+	//! true if pullAppConfigValues has been called before being ready
+	bool pendingConfigPull;
+	bool pendingConfigForceNetwork;
+	//! measure the time of startup stages
+	QElapsedTimer startupTimer;
+	//! the time of each startup stage
+	QVariantMap startupTimings;
+	//! record the time of a startup stage
+	void traceStartup( QString mark );
+
+	//! the url prefix of all endpoints
+	QUrl baseUrl;
+	//! the sub-directory of the cache used by this client
+	QString cacheNamespace;
 
 	//! PARSE Keys
 	QString appId;
@@ -151,7 +465,7 @@ private:
 	//! current user
 	QParseUser* user;
 
-	//! the newtork manager for sending requests to cloud backend
+	//! the newtork manager of the QParse thread; used for installation and app config
 	QNetworkAccessManager* net;
 	//! inner private class for storing data about operations on Parse
 	class OperationData {
@@ -163,7 +477,20 @@ private:
 			, netMethod(GET)
 			, dataToPost()
 			, fileToPost(NULL)
-			, mimeDb() { }
+			, mimeDb()
+			, skipCache(false)
+			, dispatcher(NULL)
+			, retries(0)
+			, sentTimer()
+			, submittedTimer()
+			, dispatchedAt(-1)
+			, sentAt(-1)
+			, firstByteAt(-1)
+			, statsEndpoint()
+			, sentBody() { }
+		~OperationData() {
+			delete netRequest;
+		}
 		QParseRequest* parseRequest;
 		QParseReply* parseReply;
 		QNetworkRequest* netRequest;
@@ -172,21 +499,42 @@ private:
 		QJsonObject dataToPost;
 		QFile* fileToPost;
 		QMimeDatabase mimeDb;
+		//! true means the cached data failed to load and the network has to be used
+		bool skipCache;
+		/*! the dispatcher of the thread that submitted the request
+		 *  \warning it's deleted when its thread exits; check it with enqueueOn before using it
+		 */
+		QParseDispatcher* dispatcher;
+		//! the number of times the request has been sent again after being throttled
+		int retries;
+		//! measure the latency of the network request
+		QElapsedTimer sentTimer;
+		//! the time of the stages of the operation, in nanoseconds since the submission
+		QElapsedTimer submittedTimer;
+		qint64 dispatchedAt;
+		qint64 sentAt;
+		qint64 firstByteAt;
+		//! the endpoint on which the timings are recorded (see QParseStats)
+		QString statsEndpoint;
+		//! the body sent, kept only while recording the requests (see QParseCapture)
+		QByteArray sentBody;
 	};
-	/*! the queue of the operation to process
-	 *  A parseRequest will be put in this queue and as soon as possible
-	 *  will be processed and created a netRequest to send over internet
-	 */
-	QQueue<OperationData*> operationsQueue;
-	//! the map of operation sent to Parse waiting for a netReply to process
-	QMap<QNetworkReply*, OperationData*> operationsPending;
 
-	//! Timer for triggering the execution of processOperationsQueue()
-	QTimer* timer;
+	//! create the reply and the operation of the request, without enqueuing it
+	OperationData* createOperation( QParseRequest* request, OperationData::NetMethod netMethod );
+	//! enqueue the operation, returning the future of its reply
+	QFuture<QParseResult> submitAsync( OperationData* data );
 
 	//! inner private class for handling cached items
 	class CacheData {
 	public:
+		CacheData()
+			: isJson(true)
+			, localFile()
+			, createdAt()
+			, bundled(false)
+			, packed(false)
+			, codec() { }
 		//! the cached data can be only a Json object or a binary file
 		bool isJson;
 		//! the local file where data is cached
@@ -195,6 +543,15 @@ private:
 		QDateTime createdAt;
 		//! true if the entry is bunbled into the app
 		bool bundled;
+		/*! true if the entry is stored into the bundled pack (see QParsePack)
+		 *  For Json the data is read from the pack; files are extracted to localFile on first use
+		 */
+		bool packed;
+		/*! the codec used for storing the data on disk
+		 *  empty means raw data; "zlib" means compressed with qCompress
+		 *  \note only Json data can be compressed, files are always stored raw
+		 */
+		QString codec;
 	};
 	//! all cached data indexed by QUrl request
 	QMap<QUrl, CacheData> cache;
@@ -202,23 +559,56 @@ private:
 	QString cacheDir;
 	//! INI file containing the cache data info
 	QString cacheIni;
-	//! load all cache data info from the disk
+	//! true means Json data will be compressed before to be written on cache
+	bool cacheCompression;
+	//! Json data smaller than this (in bytes) will be stored raw
+	int cacheCompressionThreshold;
+	//! it performs all disk I/O of the cache; it lives on the cache thread shared by all clients
+	QParseCacheWorker* cacheWorker;
+	//! the operations waiting for the cache worker to read the data of the url
+	QMultiMap<QUrl, OperationData*> cacheReadsPending;
+	//! the operations waiting for the cache worker to write the file of the url
+	QMultiMap<QUrl, OperationData*> cacheWritesPending;
+	//! load all cache data info from the disk (asynchronously, see onCacheIndexLoaded)
 	void loadCacheInfoData();
+	//! remove the entry from the cache, and its file if no other entries refer to it
+	void removeCacheEntry( QUrl url );
+	/*! send a snapshot of all cache data info to the worker for writing it on disk
+	 *  \warning the caller must hold cacheLock
+	 */
+	void saveCacheInfoData();
 	//! update/write a cache element
-	void updateCache( QNetworkReply* reply, OperationData* opdata );
+	void updateCache( QUrl url, QByteArray data, OperationData* opdata );
 	//! return true if there is a valid cached data for given request
 	bool isRequestCached( QUrl url );
-	//! fill the reply with cached data
-	void fillWithCachedData( QUrl url, QParseReply* reply );
-	//! return the Json object cached at given url
-	QJsonObject getCachedJson( QUrl url );
+	/*! fill the reply with cached data
+	 *  \note for Json data the reply is finished asynchronously when the data has been read
+	 */
+	void fillWithCachedData( QUrl url, OperationData* opdata );
+	//! ask to the cache worker the data cached at url; the result arrives on onCacheReadFinished
+	void readCachedData( QUrl url );
+	//! update the app config from the raw Json returned by PARSE
+	void updateAppConfig( QByteArray rawData );
 	//! save installation data on cache dir
 	void saveInstallation();
 	//! load installation (if any) from the cache dir
 	void loadInstallation();
 
-	//! return a unique file name into the cacheDir (return full path)
-	QString getUniqueCacheFilename();
+	/*! the number of cache entries referring to each file into the cacheDir
+	 *  Files are named by the hash of their content, so different urls with the
+	 *  same data share the same file, and it's removed only when no entry refers to it
+	 */
+	QHash<QString, int> cacheBlobRefs;
+	//! return the file name into the cacheDir (full path) where the data will be stored
+	QString getCacheBlobFilename( QByteArray data, const CacheData& cacheData, OperationData* opdata );
+	/*! add an entry referring to the file
+	 *  \warning the caller must hold cacheLock for writing
+	 */
+	void retainCacheBlob( QString filename );
+	/*! remove an entry referring to the file, and delete the file if it was the last one
+	 *  \warning the caller must hold cacheLock for writing
+	 */
+	void releaseCacheBlob( QString filename );
 };
 
 #endif // QPARSE_H
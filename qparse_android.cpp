@@ -1,5 +1,6 @@
 
 #include "qparse.h"
+#include "qparselogging.h"
 #include <QNetworkAccessManager>
 #include <QtAndroid>
 #include <QtAndroidExtras>
@@ -20,7 +21,7 @@ void QParse::createInstallation( QStringList channels, QString timeZone ) {
 				"(Ljava/lang/String;Ljava/lang/String;Landroid/os/Bundle;)Ljava/lang/String;",
 				senderId.object<jstring>(), scope.object<jstring>(), NULL);
 	deviceToken = token.toString();
-	qDebug() << "TOKEN " << deviceToken;
+	qparseDebug( qparseInstallation ) << "device token" << deviceToken;
 
 	QAndroidJniEnvironment env;
 	if (env->ExceptionCheck()) {
@@ -31,19 +32,17 @@ void QParse::createInstallation( QStringList channels, QString timeZone ) {
 	if ( installation.contains("deviceToken") ) {
 		QString currDeviceToken = installation["deviceToken"].toString();
 		if ( deviceToken == currDeviceToken ) {
-			qDebug() << "VALID DEVICE TOKEN";
+			qparseDebug( qparseInstallation ) << "valid device token";
 			return;
 		} else {
 			installation = QJsonObject();
-			qDebug() << "INVALID DEVICE TOKEN: CREATE A NEW INSTALLATION ROW";
+			qparseDebug( qparseInstallation ) << "invalid device token, create a new installation row";
 		}
 	}
 
 	// Prepare the request
 	// direct request, the reply will be handled on onRequestFinished
-	QNetworkRequest request(QUrl("https://api.parse.com/1/installations"));
-	request.setRawHeader("X-Parse-Application-Id", appId.toLatin1());
-	request.setRawHeader("X-Parse-REST-API-Key", restKey.toLatin1());
+	QNetworkRequest request = createNetworkRequest( getEndpoint("installations") );
 	request.setRawHeader("Content-Type", "application/json");
 	installation["deviceType"] = "android";
 	installation["pushType"] = "gcm";
@@ -0,0 +1,9 @@
+#include "qparse.h"
+#include "qparselogging.h"
+
+void QParse::createInstallation( QStringList channels, QString timeZone ) {
+	Q_UNUSED( channels )
+	Q_UNUSED( timeZone )
+	// there are no push notifications on desktop, so there is no device token to register
+	qparseDebug( qparseInstallation ) << "installation not available on this platform";
+}
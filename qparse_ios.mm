@@ -63,9 +63,7 @@ void QParse::createInstallation( QStringList channels, QString timeZone ) {
 void QParse::sendInstallationPostRequest( QString token ) {
 	// Prepare the request
 	// direct request, the reply will be handled on onRequestFinished
-	QNetworkRequest request(QUrl("https://api.parse.com/1/installations"));
-	request.setRawHeader("X-Parse-Application-Id", appId.toLatin1());
-	request.setRawHeader("X-Parse-REST-API-Key", restKey.toLatin1());
+	QNetworkRequest request = createNetworkRequest( getEndpoint("installations") );
 	request.setRawHeader("Content-Type", "application/json");
 	installation["deviceType"] = "ios";
 	installation["deviceToken"] = token;
@@ -0,0 +1,190 @@
+
+#include "qparsebatch.h"
+#include "qparse.h"
+#include "qparseobject.h"
+#include "qparserequest.h"
+#include "qparsereply.h"
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include "qparselogging.h"
+
+QParseBatch::QParseBatch( Operation operation, QList<QParseObject*> objects, QParse* client )
+	: QObject(QParse::parentForCurrentThread(client))
+	, operation(operation)
+	, objects(objects)
+	, client(client ? client : QParse::instance())
+	, chunks()
+	, chunksPending()
+	, succeeded()
+	, errors()
+	, done(false) {
+	if ( operation == Fetch ) {
+		// one query for each class, so the objects are grouped by class
+		QMap< QString, QList<QParseObject*> > classes;
+		foreach( QParseObject* object, objects ) {
+			if ( object->getObjectId().isEmpty() ) {
+				setFailed( object, 104, "missing object id" );
+				continue;
+			}
+			classes[object->parseClassName()] << object;
+		}
+		foreach( QList<QParseObject*> classObjects, classes ) {
+			for( int i=0; i<classObjects.size(); i+=chunkSize ) {
+				chunks.enqueue( classObjects.mid( i, chunkSize ) );
+			}
+		}
+	} else {
+		QList<QParseObject*> toSend;
+		foreach( QParseObject* object, objects ) {
+			if ( operation == Delete && object->getObjectId().isEmpty() ) {
+				setFailed( object, 104, "missing object id" );
+				continue;
+			}
+			toSend << object;
+		}
+		for( int i=0; i<toSend.size(); i+=chunkSize ) {
+			chunks.enqueue( toSend.mid( i, chunkSize ) );
+		}
+	}
+	// gives the time to connect to finished signal
+	QMetaObject::invokeMethod( this, "sendChunks", Qt::QueuedConnection );
+}
+
+QParseBatch::Operation QParseBatch::getOperation() const {
+	return operation;
+}
+
+QList<QParseObject*> QParseBatch::getObjects() const {
+	return objects;
+}
+
+bool QParseBatch::isDone() const {
+	return done;
+}
+
+QList<QParseObject*> QParseBatch::getSucceeded() const {
+	return succeeded;
+}
+
+QList<QParseObject*> QParseBatch::getFailed() const {
+	return errors.keys();
+}
+
+bool QParseBatch::hasError() const {
+	return !errors.isEmpty();
+}
+
+QString QParseBatch::getErrorMessage( QParseObject* object ) const {
+	return errors.value( object ).second;
+}
+
+int QParseBatch::getErrorCode( QParseObject* object ) const {
+	return errors.value( object ).first;
+}
+
+void QParseBatch::sendChunks() {
+	while( !chunks.isEmpty() && chunksPending.size() < maxParallelChunks ) {
+		QList<QParseObject*> chunk = chunks.dequeue();
+		QParseReply* reply = sendChunk( chunk );
+		chunksPending[reply] = chunk;
+		connect( reply, &QParseReply::finished, this, &QParseBatch::onChunkReply );
+	}
+	if ( chunks.isEmpty() && chunksPending.isEmpty() && !done ) {
+		done = true;
+		emit doneChanged( done );
+		emit finished( this );
+	}
+}
+
+QParseReply* QParseBatch::sendChunk( QList<QParseObject*> chunk ) {
+	if ( operation == Fetch ) {
+		QStringList ids;
+		foreach( QParseObject* object, chunk ) {
+			ids << object->getObjectId();
+		}
+		// the same object can be pointed by many objects
+		ids.removeDuplicates();
+		QJsonObject in;
+		in["$in"] = QJsonArray::fromStringList( ids );
+		QJsonObject where;
+		where["objectId"] = in;
+		QParseRequest* request = new QParseRequest( chunk.first()->parseClassName(), client );
+		request->addOption( "where", QJsonDocument(where).toJson(QJsonDocument::Compact) );
+		request->addOption( "limit", QString::number(ids.size()) );
+		// fetching means getting the current data on PARSE
+		request->setCacheControl( QParse::AlwaysNetwork );
+		return client->get( request );
+	}
+	// the path of the operations is relative to the host, like /1/classes/...
+	QJsonArray operations;
+	foreach( QParseObject* object, chunk ) {
+		QJsonObject operationData;
+		QString path = QString("classes/%1").arg( object->parseClassName() );
+		if ( operation == Delete ) {
+			operationData["method"] = QString("DELETE");
+			path += "/"+object->getObjectId();
+		} else if ( object->getObjectId().isEmpty() ) {
+			operationData["method"] = QString("POST");
+			operationData["body"] = object->toJson();
+		} else {
+			operationData["method"] = QString("PUT");
+			path += "/"+object->getObjectId();
+			operationData["body"] = object->toJson();
+		}
+		operationData["path"] = client->getEndpoint( path ).path();
+		operations.append( operationData );
+	}
+	QJsonObject body;
+	body["requests"] = operations;
+	QParseRequest* request = new QParseRequest( "batch", client );
+	request->setBody( body );
+	return client->post( request );
+}
+
+void QParseBatch::onChunkReply( QParseReply* reply ) {
+	QList<QParseObject*> chunk = chunksPending.take( reply );
+	if ( reply->getHasError() ) {
+		// the whole request failed, so each object of the chunk
+		foreach( QParseObject* object, chunk ) {
+			setFailed( object, reply->getErrorCode(), reply->getErrorMessage() );
+		}
+	} else if ( operation == Fetch ) {
+		QMap<QString, QJsonObject> fetched;
+		foreach( QJsonValue result, reply->getJson()["results"].toArray() ) {
+			fetched[result.toObject()["objectId"].toString()] = result.toObject();
+		}
+		foreach( QParseObject* object, chunk ) {
+			if ( fetched.contains( object->getObjectId() ) ) {
+				object->fromJson( fetched[object->getObjectId()] );
+				succeeded << object;
+			} else {
+				setFailed( object, 101, "object not found" );
+			}
+		}
+	} else {
+		// the results are in the same order of the operations
+		QJsonArray results = reply->getJson()["results"].toArray();
+		for( int i=0; i<chunk.size(); i++ ) {
+			QJsonObject result = results.at(i).toObject();
+			if ( result.contains("success") ) {
+				if ( operation == Save ) {
+					chunk[i]->fromJson( result["success"].toObject() );
+				}
+				succeeded << chunk[i];
+			} else if ( result.contains("error") ) {
+				QJsonObject error = result["error"].toObject();
+				setFailed( chunk[i], error["code"].toInt(), error["error"].toString() );
+			} else {
+				setFailed( chunk[i], -1, "missing result of the batch operation" );
+			}
+		}
+	}
+	reply->deleteLater();
+	sendChunks();
+}
+
+void QParseBatch::setFailed( QParseObject* object, int code, QString message ) {
+	qparseDebug( qparseQuery ) << "batch operation failed on" << object->parseClassName() << object->getObjectId() << message;
+	errors[object] = qMakePair( code, message );
+}
@@ -0,0 +1,85 @@
+#ifndef QPARSEBATCH_H
+#define QPARSEBATCH_H
+
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QQueue>
+
+class QParse;
+class QParseObject;
+class QParseReply;
+
+/*! It performs an operation on many objects at once
+ *
+ *  The saves and the deletes are sent with the batch operations of PARSE,
+ *  the fetches with one query on objectId for each class; the objects are
+ *  split in chunks of chunkSize, and at most maxParallelChunks chunks are
+ *  sent in parallel
+ *
+ *  The result of each object is reported separately, because PARSE
+ *  executes each operation of a batch independently from the others
+ *
+ *  Create it with QParseObject::saveAll, QParseObject::deleteAll and QParseObject::fetchAll
+ */
+class QParseBatch : public QObject {
+	Q_OBJECT
+	//! true when all the chunks have been processed
+	Q_PROPERTY( bool done READ isDone NOTIFY doneChanged )
+public:
+	enum Operation { Save, Delete, Fetch };
+	Q_ENUM( Operation )
+	//! the maximum number of objects on a batch request of PARSE
+	static const int chunkSize = 50;
+	//! the maximum number of chunks sent in parallel
+	static const int maxParallelChunks = 4;
+	/*! constructor
+	 *  The chunks are sent as soon as the control returns to the event loop,
+	 *  so connect to the finished signal just after the creation
+	 *  \param client the client used; QParse::instance() when NULL
+	 */
+	QParseBatch( Operation operation, QList<QParseObject*> objects, QParse* client=NULL );
+public slots:
+	Operation getOperation() const;
+	//! return all the objects of the batch
+	QList<QParseObject*> getObjects() const;
+	bool isDone() const;
+	//! return the objects on which the operation succeeded
+	QList<QParseObject*> getSucceeded() const;
+	//! return the objects on which the operation failed
+	QList<QParseObject*> getFailed() const;
+	//! true if the operation failed on at least one object
+	bool hasError() const;
+	//! return the error message of the object, if the operation failed on it
+	QString getErrorMessage( QParseObject* object ) const;
+	//! return the error code of the object, if the operation failed on it
+	int getErrorCode( QParseObject* object ) const;
+signals:
+	void doneChanged( bool done );
+	//! emitted when the operation has been done on all the objects
+	void finished( QParseBatch* batch );
+private slots:
+	//! send the chunks until maxParallelChunks are pending
+	void sendChunks();
+	void onChunkReply( QParseReply* reply );
+private:
+	//! return the reply of the request of the chunk
+	QParseReply* sendChunk( QList<QParseObject*> chunk );
+	//! mark the object as failed
+	void setFailed( QParseObject* object, int code, QString message );
+
+	Operation operation;
+	QList<QParseObject*> objects;
+	QParse* client;
+	//! the chunks not sent yet; when fetching all the objects of a chunk have the same class
+	QQueue< QList<QParseObject*> > chunks;
+	//! the chunks sent, waiting for the reply
+	QMap< QParseReply*, QList<QParseObject*> > chunksPending;
+	QList<QParseObject*> succeeded;
+	//! the code and message of the error of each failed object
+	QMap< QParseObject*, QPair<int,QString> > errors;
+	bool done;
+};
+
+#endif // QPARSEBATCH_H
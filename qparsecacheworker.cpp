@@ -0,0 +1,266 @@
+
+#include "qparsecacheworker.h"
+#include "qparsepack.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QTimer>
+#include <QSettings>
+#include <QVariantMap>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QDir>
+#include "qparselogging.h"
+
+QParseCacheWorker::QParseCacheWorker( QObject* parent )
+	: QObject(parent)
+	, pendingWrites()
+	, pendingIndexFile()
+	, pendingIndex()
+	, hasPendingIndex(false)
+	, pack(NULL) {
+	// the timer is a child, so it will be moved on the worker thread together with this object
+	flushTimer = new QTimer(this);
+	flushTimer->setInterval(100);
+	flushTimer->setSingleShot(true);
+	connect( flushTimer, &QTimer::timeout, this, &QParseCacheWorker::flush );
+}
+
+QParseCacheWorker::~QParseCacheWorker() {
+	delete pack;
+}
+
+void QParseCacheWorker::loadIndex( QString cacheDir, QString cacheIni, QString bundleCacheDir ) {
+	QElapsedTimer loadingTimer;
+	loadingTimer.start();
+	QDir dir(cacheDir);
+	dir.mkpath(cacheDir);
+
+	QVariantList entries;
+	// the pack of a previous loading is replaced
+	delete pack;
+	pack = new QParsePack();
+	if ( pack->open( bundleCacheDir+"/parsecache.pack" ) ) {
+		// the entries of the pack come first, so newer data cached on the INI replace them
+		foreach( QParsePack::Entry packEntry, pack->getEntries() ) {
+			QVariantMap entry;
+			entry["url"] = packEntry.url;
+			entry["isJson"] = packEntry.isJson;
+			entry["bundled"] = true;
+			entry["packed"] = true;
+			if ( packEntry.isJson ) {
+				entry["localFile"] = pack->getFilename();
+			} else {
+				// files need a local url, so they are extracted on first use (see extractPacked)
+				// where they would be stored if downloaded
+				QString localFile = cacheDir+"/"+packEntry.hash;
+				if ( !packEntry.suffix.isEmpty() ) {
+					localFile += "."+packEntry.suffix;
+				}
+				entry["localFile"] = localFile;
+			}
+			entry["createdAt"] = packEntry.createdAt;
+			entry["codec"] = packEntry.codec;
+			entries << entry;
+		}
+	} else if ( !QFile::exists(cacheDir+"/"+cacheIni) && QFile::exists(bundleCacheDir+"/"+cacheIni) ) {
+		qparseDebug( qparseCache ) << "copying the bundled cache index to the local cache index";
+		// first time here, take data from bundled parsecache
+		QSettings bundleSets( bundleCacheDir+"/"+cacheIni, QSettings::IniFormat );
+		QSettings cacheSets( cacheDir+"/"+cacheIni, QSettings::IniFormat );
+		bundleSets.setIniCodec("UTF-8");
+		cacheSets.setIniCodec("UTF-8");
+		int size = bundleSets.beginReadArray("caches");
+		cacheSets.beginWriteArray("caches");
+		QStringList props;
+		props << "url" << "createdAt" << "isJson" << "localFile" << "codec";
+		for( int i=0; i<size; i++ ) {
+			bundleSets.setArrayIndex(i);
+			cacheSets.setArrayIndex(i);
+			foreach( QString prop, props ) {
+				cacheSets.setValue(prop, bundleSets.value(prop));
+			}
+			cacheSets.setValue("bundled", true);
+		}
+		bundleSets.endArray();
+		cacheSets.endArray();
+		cacheSets.sync();
+	}
+
+	QSettings cacheSets( cacheDir+"/"+cacheIni, QSettings::IniFormat );
+	cacheSets.setIniCodec("UTF-8");
+	int size = cacheSets.beginReadArray("caches");
+	for( int i=0; i<size; i++ ) {
+		cacheSets.setArrayIndex(i);
+		QVariantMap entry;
+		entry["url"] = cacheSets.value("url").toUrl();
+		entry["isJson"] = cacheSets.value("isJson").toBool();
+		entry["bundled"] = cacheSets.value("bundled").toBool();
+		if ( entry["bundled"].toBool() ) {
+			entry["localFile"] = bundleCacheDir+"/"+cacheSets.value("localFile").toString();
+		} else {
+			entry["localFile"] = cacheDir+"/"+cacheSets.value("localFile").toString();
+		}
+		entry["createdAt"] = cacheSets.value("createdAt").toDateTime();
+		entry["codec"] = cacheSets.value("codec").toString();
+		entries << entry;
+	}
+	cacheSets.endArray();
+	emit indexLoaded( entries, loadingTimer.elapsed() );
+}
+
+void QParseCacheWorker::write( QUrl key, QString filename, QByteArray data, QString codec, bool coalesce ) {
+	if ( !coalesce ) {
+		// any previous queued data for the same file is now obsolete
+		pendingWrites.remove( filename );
+		bool ok = writeFile( filename, data, codec );
+		emit writeFinished( key, filename, ok );
+		return;
+	}
+	PendingWrite pending;
+	pending.key = key;
+	pending.data = data;
+	pending.codec = codec;
+	pendingWrites[filename] = pending;
+	scheduleFlush();
+}
+
+void QParseCacheWorker::writeBlob( QUrl key, QString filename, QByteArray data, QString codec, bool coalesce ) {
+	if ( pendingWrites.contains(filename) || QFile::exists(filename) ) {
+		// same name means same content, nothing to write
+		if ( !coalesce && pendingWrites.contains(filename) ) {
+			// but who is waiting for the file needs it on disk now
+			PendingWrite pending = pendingWrites.take( filename );
+			bool ok = writeFile( filename, pending.data, pending.codec );
+			emit writeFinished( pending.key, filename, ok );
+			if ( pending.key == key ) return;
+			emit writeFinished( key, filename, ok );
+			return;
+		}
+		emit writeFinished( key, filename, true );
+		return;
+	}
+	write( key, filename, data, codec, coalesce );
+}
+
+void QParseCacheWorker::writeIndex( QString iniFile, QVariantList entries ) {
+	pendingIndexFile = iniFile;
+	pendingIndex = entries;
+	hasPendingIndex = true;
+	scheduleFlush();
+}
+
+void QParseCacheWorker::read( QUrl key, QString filename, QString codec ) {
+	// data not written yet are still valid data
+	if ( pendingWrites.contains(filename) ) {
+		emit readFinished( key, pendingWrites[filename].data, true );
+		return;
+	}
+	QFile cacheFile( filename );
+	if ( !cacheFile.open( QIODevice::ReadOnly ) ) {
+		qparseWarning( qparseCache ) << "cannot read on cache directory" << filename;
+		emit readFinished( key, QByteArray(), false );
+		return;
+	}
+	QByteArray data = cacheFile.readAll();
+	cacheFile.close();
+	if ( !decode( data, codec ) ) {
+		qparseWarning( qparseCache ) << "corrupted data on cache directory" << filename;
+		emit readFinished( key, QByteArray(), false );
+		return;
+	}
+	emit readFinished( key, data, true );
+}
+
+void QParseCacheWorker::readPacked( QUrl key ) {
+	if ( !pack || !pack->contains(key) ) {
+		emit readFinished( key, QByteArray(), false );
+		return;
+	}
+	QByteArray data = pack->getData( key );
+	if ( !decode( data, pack->getEntry(key).codec ) ) {
+		qparseWarning( qparseCache ) << "corrupted data on the bundled pack" << key;
+		emit readFinished( key, QByteArray(), false );
+		return;
+	}
+	emit readFinished( key, data, true );
+}
+
+void QParseCacheWorker::extractPacked( QUrl key, QString filename ) {
+	if ( !pack || !pack->contains(key) ) {
+		emit writeFinished( key, filename, false );
+		return;
+	}
+	// files are never compressed
+	writeBlob( key, filename, pack->getData(key), QString(), false );
+}
+
+void QParseCacheWorker::remove( QString filename ) {
+	pendingWrites.remove( filename );
+	if ( QFile::exists(filename) && !QFile::remove(filename) ) {
+		qparseWarning( qparseCache ) << "cannot remove from cache directory" << filename;
+	}
+}
+
+void QParseCacheWorker::flush() {
+	flushTimer->stop();
+	QMap<QString, PendingWrite> writes = pendingWrites;
+	pendingWrites.clear();
+	foreach( QString filename, writes.keys() ) {
+		PendingWrite pending = writes[filename];
+		bool ok = writeFile( filename, pending.data, pending.codec );
+		emit writeFinished( pending.key, filename, ok );
+	}
+	if ( hasPendingIndex ) {
+		hasPendingIndex = false;
+		QSettings cacheSets( pendingIndexFile, QSettings::IniFormat );
+		cacheSets.setIniCodec("UTF-8");
+		cacheSets.beginWriteArray("caches");
+		for( int i=0; i<pendingIndex.size(); i++ ) {
+			cacheSets.setArrayIndex(i);
+			QVariantMap entry = pendingIndex[i].toMap();
+			foreach( QString prop, entry.keys() ) {
+				cacheSets.setValue(prop, entry[prop]);
+			}
+		}
+		cacheSets.endArray();
+		cacheSets.sync();
+		if ( cacheSets.status() != QSettings::NoError ) {
+			qparseWarning( qparseCache ) << "cannot write the cache index" << pendingIndexFile;
+		}
+		pendingIndex.clear();
+	}
+}
+
+bool QParseCacheWorker::writeFile( QString filename, QByteArray data, QString codec ) {
+	// QSaveFile writes on a temporary file and renames it on commit, so a file
+	// with the final name is always complete (its name is the hash of its content)
+	QSaveFile cacheFile( filename );
+	if ( !cacheFile.open( QIODevice::WriteOnly ) ) {
+		qparseWarning( qparseCache ) << "cannot write on cache directory" << filename;
+		return false;
+	}
+	if ( codec == "zlib" ) {
+		// level 1 is the fastest one, and Json compress very well even with it
+		data = qCompress( data, 1 );
+	}
+	cacheFile.write( data );
+	if ( !cacheFile.commit() ) {
+		qparseWarning( qparseCache ) << "cannot write on cache directory" << filename;
+		return false;
+	}
+	return true;
+}
+
+bool QParseCacheWorker::decode( QByteArray& data, QString codec ) {
+	if ( codec == "zlib" ) {
+		data = qUncompress( data );
+		return !data.isEmpty();
+	}
+	return true;
+}
+
+void QParseCacheWorker::scheduleFlush() {
+	if ( !flushTimer->isActive() ) {
+		flushTimer->start();
+	}
+}
@@ -0,0 +1,102 @@
+#ifndef QPARSECACHEWORKER_H
+#define QPARSECACHEWORKER_H
+
+#include <QObject>
+#include <QUrl>
+#include <QMap>
+#include <QByteArray>
+#include <QVariantList>
+
+class QTimer;
+class QParsePack;
+
+/*! This object performs all the disk I/O of the QParse cache
+ *
+ *  It lives on a dedicated thread owned by QParse, and all its slots
+ *  must be invoked with a queued connection (QMetaObject::invokeMethod)
+ *
+ *  Writes are queued and coalesced: writing the same file many times before
+ *  the next flush results into a single write on disk, and the same happens
+ *  for the cache index that is written only with the last snapshot received
+ *
+ *  \warning Never create by yourself, it's created by QParse
+ */
+class QParseCacheWorker : public QObject {
+	Q_OBJECT
+public:
+	QParseCacheWorker( QObject* parent=0 );
+	~QParseCacheWorker();
+public slots:
+	/*! create the cache directory and load the cache index from the INI file
+	 *  If the bundled parsecache.pack exists, its entries are loaded from it
+	 *  (flagged as packed) and are read directly from the pack;
+	 *  otherwise, if the INI does not exist yet, the bundled one will be copied
+	 *  The result is returned with indexLoaded signal
+	 */
+	void loadIndex( QString cacheDir, QString cacheIni, QString bundleCacheDir );
+	/*! queue the writing of data on the filename
+	 *  \param key is the url of the request cached; it's returned back with writeFinished
+	 *  \param codec is the codec to use for storing data ("zlib" or empty for raw data)
+	 *  \param coalesce if false the data is written immediately without waiting the next flush
+	 */
+	void write( QUrl key, QString filename, QByteArray data, QString codec, bool coalesce );
+	/*! like write, but for files named by the hash of their content
+	 *  if the file already exists (or it's queued) the data is not written again
+	 */
+	void writeBlob( QUrl key, QString filename, QByteArray data, QString codec, bool coalesce );
+	//! queue the writing of the cache index; only the last snapshot will be written
+	void writeIndex( QString iniFile, QVariantList entries );
+	/*! read the data stored on filename and decode it using the codec
+	 *  The result is returned with readFinished signal
+	 */
+	void read( QUrl key, QString filename, QString codec );
+	//! like read, but the data is taken from the bundled pack
+	void readPacked( QUrl key );
+	/*! extract a file from the bundled pack to the filename
+	 *  The result is returned with writeFinished signal
+	 */
+	void extractPacked( QUrl key, QString filename );
+	//! remove the file from the cache directory
+	void remove( QString filename );
+	//! write down on disk all pending data
+	void flush();
+signals:
+	/*! emitted when the cache index has been loaded
+	 *  \param entries contains a QVariantMap for each entry with full path on localFile
+	 *  \param loadingTime the milliseconds spent for loading it
+	 */
+	void indexLoaded( QVariantList entries, qint64 loadingTime );
+	//! emitted when a read has been completed; if ok is false the data is not valid
+	void readFinished( QUrl key, QByteArray data, bool ok );
+	//! emitted when a write has been completed; if ok is false the data has not been written
+	void writeFinished( QUrl key, QString filename, bool ok );
+private:
+	//! write the data on disk encoding with the codec
+	bool writeFile( QString filename, QByteArray data, QString codec );
+	//! decode the data accordingly to the codec; return false if the data is corrupted
+	bool decode( QByteArray& data, QString codec );
+	//! start the flush timer if not active yet
+	void scheduleFlush();
+
+	//! inner private class for storing the data waiting to be written
+	class PendingWrite {
+	public:
+		QUrl key;
+		QByteArray data;
+		QString codec;
+	};
+	//! all pending writes indexed by filename
+	QMap<QString, PendingWrite> pendingWrites;
+	//! the INI file where write the pending index
+	QString pendingIndexFile;
+	//! the last snapshot of the cache index not written yet
+	QVariantList pendingIndex;
+	//! true if the pendingIndex has to be written
+	bool hasPendingIndex;
+	//! Timer for triggering the flush
+	QTimer* flushTimer;
+	//! the bundled pack, if any
+	QParsePack* pack;
+};
+
+#endif // QPARSECACHEWORKER_H
@@ -0,0 +1,148 @@
+
+#include "qparsecapture.h"
+#include "qparselogging.h"
+#include <QMutexLocker>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QUrlQuery>
+#include <QDateTime>
+
+//! the value put in place of the credentials
+static const char* strippedValue = "***";
+
+QParseCapture::QParseCapture()
+	: mutex()
+	, file()
+	, opened(0)
+	, timer() {
+}
+
+QParseCapture::~QParseCapture() {
+	close();
+}
+
+bool QParseCapture::open( QString filename, QUrl baseUrl ) {
+	QMutexLocker locker( &mutex );
+	if ( file.isOpen() ) {
+		file.close();
+	}
+	file.setFileName( filename );
+	if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) ) {
+		qparseWarning( qparseNetwork ) << "cannot write the capture" << filename;
+		opened.storeRelease( 0 );
+		return false;
+	}
+	QJsonObject header;
+	header["qparseCapture"] = 1;
+	header["baseUrl"] = baseUrl.toString();
+	header["startedAt"] = QDateTime::currentDateTimeUtc().toString( Qt::ISODate );
+	file.write( QJsonDocument(header).toJson( QJsonDocument::Compact )+"\n" );
+	file.flush();
+	timer.start();
+	opened.storeRelease( 1 );
+	return true;
+}
+
+void QParseCapture::close() {
+	QMutexLocker locker( &mutex );
+	opened.storeRelease( 0 );
+	if ( file.isOpen() ) {
+		file.close();
+	}
+}
+
+void QParseCapture::record( const QNetworkRequest& request, QByteArray method, QByteArray requestBody,
+							QNetworkReply* reply, QByteArray responseBody, qint64 sentAgo, double ttfb ) {
+	QJsonObject entry;
+	entry["method"] = QString::fromLatin1( method );
+	entry["url"] = strip( request.url() ).toString();
+	QJsonObject requestHeaders;
+	foreach( QByteArray header, request.rawHeaderList() ) {
+		if ( isCredential(header) ) continue;
+		requestHeaders[QString::fromLatin1(header)] = QString::fromLatin1( request.rawHeader(header) );
+	}
+	entry["requestHeaders"] = requestHeaders;
+	if ( !requestBody.isEmpty() ) {
+		entry["requestBody"] = QString::fromUtf8( strip(requestBody) );
+	}
+	entry["status"] = reply->attribute( QNetworkRequest::HttpStatusCodeAttribute ).toInt();
+	entry["error"] = int( reply->error() );
+	QJsonObject responseHeaders;
+	foreach( QNetworkReply::RawHeaderPair pair, reply->rawHeaderPairs() ) {
+		if ( isCredential(pair.first) ) continue;
+		responseHeaders[QString::fromLatin1(pair.first)] = QString::fromLatin1( pair.second );
+	}
+	entry["responseHeaders"] = responseHeaders;
+	if ( reply->header( QNetworkRequest::ContentTypeHeader ).toString().contains("json") ) {
+		entry["responseBody"] = QString::fromUtf8( strip(responseBody) );
+	} else {
+		entry["responseBody"] = QString::fromLatin1( responseBody.toBase64() );
+		entry["responseEncoding"] = QString("base64");
+	}
+	entry["ttfb"] = ttfb;
+	entry["duration"] = sentAgo;
+	QMutexLocker locker( &mutex );
+	if ( !file.isOpen() ) return;
+	// the requests sent before the start of recording are at its start
+	entry["t"] = qMax( qint64(0), timer.elapsed() - sentAgo );
+	file.write( QJsonDocument(entry).toJson( QJsonDocument::Compact )+"\n" );
+	file.flush();
+}
+
+QUrl QParseCapture::strip( QUrl url ) {
+	if ( !url.hasQuery() ) return url;
+	QUrlQuery query( url );
+	QList< QPair<QString, QString> > items = query.queryItems( QUrl::FullyDecoded );
+	bool changed = false;
+	for( int i=0; i<items.size(); i++ ) {
+		if ( items[i].first == "password" || items[i].first == "sessionToken" ) {
+			items[i].second = strippedValue;
+			changed = true;
+		}
+	}
+	if ( !changed ) return url;
+	query.setQueryItems( items );
+	url.setQuery( query );
+	return url;
+}
+
+QByteArray QParseCapture::strip( QByteArray data ) {
+	QJsonParseError error;
+	QJsonDocument doc = QJsonDocument::fromJson( data, &error );
+	if ( error.error != QJsonParseError::NoError ) return data;
+	if ( doc.isArray() ) {
+		return QJsonDocument( strip(QJsonValue(doc.array())).toArray() ).toJson( QJsonDocument::Compact );
+	}
+	return QJsonDocument( strip(QJsonValue(doc.object())).toObject() ).toJson( QJsonDocument::Compact );
+}
+
+bool QParseCapture::isCredential( QByteArray header ) {
+	header = header.toLower();
+	return header == "x-parse-application-id" || header == "x-parse-rest-api-key" ||
+		   header == "x-parse-session-token" || header == "x-parse-master-key" ||
+		   header == "authorization" || header == "cookie" || header == "set-cookie";
+}
+
+QJsonValue QParseCapture::strip( QJsonValue value ) {
+	if ( value.isArray() ) {
+		QJsonArray array = value.toArray();
+		for( int i=0; i<array.size(); i++ ) {
+			array[i] = strip( QJsonValue(array[i]) );
+		}
+		return array;
+	}
+	if ( value.isObject() ) {
+		QJsonObject object = value.toObject();
+		foreach( QString key, object.keys() ) {
+			if ( key == "password" || key == "sessionToken" ) {
+				object[key] = QString(strippedValue);
+			} else if ( object[key].isObject() || object[key].isArray() ) {
+				object[key] = strip( QJsonValue(object[key]) );
+			}
+		}
+		return object;
+	}
+	return value;
+}
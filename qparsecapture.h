@@ -0,0 +1,77 @@
+#ifndef QPARSECAPTURE_H
+#define QPARSECAPTURE_H
+
+#include <QMutex>
+#include <QFile>
+#include <QUrl>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QJsonObject>
+
+class QNetworkRequest;
+class QNetworkReply;
+
+/*! It records the requests sent to PARSE and their replies on a file, for replaying
+ *  them later with QParseReplay
+ *
+ *  The file has one Json object per line; the first line describes the capture:
+ *  \code
+ *  { "qparseCapture": 1, "baseUrl": "https://api.parse.com/1", "startedAt": "<ISO date>" }
+ *  \endcode
+ *  and each following line is a request with its reply:
+ *  \code
+ *  { "t": <ms since the start>, "method": "GET", "url": "...", "requestHeaders": {...}, "requestBody": "...",
+ *    "status": 200, "error": <QNetworkReply::NetworkError>, "responseHeaders": {...},
+ *    "responseBody": "...", "responseEncoding": "base64" (only for binary data),
+ *    "ttfb": <ms>, "duration": <ms> }
+ *  \endcode
+ *
+ *  A request throttled by PARSE and retried is recorded once, with the reply of its last try,
+ *  so replaying it gives the same outcome as the live client got
+ *
+ *  The credentials are stripped: the PARSE keys, the session token and the cookies from the
+ *  headers, and the password and the sessionToken values from the urls and the Json bodies
+ *
+ *  It's thread-safe, the dispatchers of all threads record on it
+ *
+ *  \warning Never create by yourself, it's created by QParse (see QParse::captureFile)
+ */
+class QParseCapture {
+public:
+	QParseCapture();
+	~QParseCapture();
+	/*! start recording on the file, replacing its content
+	 *  \return false if the file cannot be written
+	 */
+	bool open( QString filename, QUrl baseUrl );
+	//! stop recording
+	void close();
+	//! true if recording; it's cheap, so it's checked before preparing the data of record
+	inline bool isOpen() const {
+		return opened.load() != 0;
+	}
+	/*! record a request and its reply
+	 *  \param sentAgo the milliseconds elapsed since the request has been sent
+	 *  \param ttfb the milliseconds from sending to the headers of the reply
+	 */
+	void record( const QNetworkRequest& request, QByteArray method, QByteArray requestBody,
+				 QNetworkReply* reply, QByteArray responseBody, qint64 sentAgo, double ttfb );
+	//! return the url without credentials; it's used also by QParseReplay for matching the requests
+	static QUrl strip( QUrl url );
+	//! return the Json data without credentials; data that is not Json is returned unchanged
+	static QByteArray strip( QByteArray data );
+	//! return true if the header carries credentials
+	static bool isCredential( QByteArray header );
+private:
+	Q_DISABLE_COPY( QParseCapture )
+	static QJsonValue strip( QJsonValue value );
+
+	QMutex mutex;
+	QFile file;
+	QAtomicInt opened;
+	//! the time since the start of recording
+	QElapsedTimer timer;
+};
+
+#endif // QPARSECAPTURE_H
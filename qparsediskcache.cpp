@@ -0,0 +1,311 @@
+
+#include "qparsediskcache.h"
+#include "qparse.h"
+#include "qparsestats.h"
+#include "qparselogging.h"
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QBuffer>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QCryptographicHash>
+#include <QNetworkAccessManager>
+#include <algorithm>
+
+//! the header of the files of the entries
+static const quint32 entryMagic = 0x51504443;
+static const quint32 entryVersion = 1;
+//! the eviction removes the entries down to this fraction of the maximum size
+static const double evictionTarget = 0.9;
+
+//! return the url as it's cached: without fragment and credentials
+static QUrl normalizedUrl( const QUrl& url ) {
+	return url.adjusted( QUrl::RemoveFragment | QUrl::RemoveUserInfo );
+}
+
+QParseDiskCacheStore::QParseDiskCacheStore( QString directory, QParseStats* stats, QObject* parent )
+	: QObject(parent)
+	, mutex()
+	, directory(directory)
+	, stats(stats)
+	// the same default of QNetworkDiskCache
+	, maximumSize(50*1024*1024)
+	, loaded(false)
+	, entries()
+	, totalSize(0) {
+}
+
+qint64 QParseDiskCacheStore::getMaximumSize() const {
+	QMutexLocker locker( &mutex );
+	return maximumSize;
+}
+
+void QParseDiskCacheStore::setMaximumSize( qint64 value ) {
+	QMutexLocker locker( &mutex );
+	maximumSize = qMax( qint64(0), value );
+	if ( loaded ) {
+		evict();
+	}
+}
+
+QNetworkCacheMetaData QParseDiskCacheStore::metaData( const QUrl& url ) {
+	QMutexLocker locker( &mutex );
+	load();
+	QString key = keyOf( url );
+	QNetworkCacheMetaData metaData;
+	if ( entries.contains(key) && !readEntry( key, url, &metaData, NULL ) ) {
+		removeEntry( key );
+	}
+	locker.unlock();
+	if ( !metaData.isValid() ) {
+		stats->recordCacheMiss();
+	}
+	return metaData;
+}
+
+QByteArray QParseDiskCacheStore::data( const QUrl& url, bool* ok ) {
+	QMutexLocker locker( &mutex );
+	load();
+	QString key = keyOf( url );
+	QByteArray data;
+	*ok = entries.contains(key) && readEntry( key, url, NULL, &data );
+	if ( *ok ) {
+		entries[key].lastUsed = QDateTime::currentMSecsSinceEpoch();
+	} else if ( entries.contains(key) ) {
+		removeEntry( key );
+	}
+	locker.unlock();
+	// the reply is served from the cache, also after a revalidation
+	if ( *ok ) {
+		stats->recordCacheHit( "http" );
+	}
+	return data;
+}
+
+void QParseDiskCacheStore::insert( const QNetworkCacheMetaData& metaData, const QByteArray& data ) {
+	QMutexLocker locker( &mutex );
+	load();
+	QString key = keyOf( metaData.url() );
+	// a stale entry downloaded again is a miss too
+	bool replaced = entries.contains(key);
+	if ( replaced ) {
+		removeEntry( key );
+	}
+	if ( data.size() <= maximumSize && writeEntry( key, metaData, data ) ) {
+		Entry& entry = entries[key];
+		entry.size = QFileInfo( directory+"/"+key ).size();
+		entry.lastUsed = QDateTime::currentMSecsSinceEpoch();
+		totalSize += entry.size;
+		evict();
+	}
+	locker.unlock();
+	if ( replaced ) {
+		stats->recordCacheMiss();
+	}
+}
+
+bool QParseDiskCacheStore::updateMetaData( const QNetworkCacheMetaData& metaData ) {
+	QMutexLocker locker( &mutex );
+	load();
+	QString key = keyOf( metaData.url() );
+	QByteArray data;
+	if ( !entries.contains(key) ) return false;
+	if ( !readEntry( key, metaData.url(), NULL, &data ) || !writeEntry( key, metaData, data ) ) {
+		removeEntry( key );
+		return false;
+	}
+	Entry& entry = entries[key];
+	qint64 size = QFileInfo( directory+"/"+key ).size();
+	totalSize += size - entry.size;
+	entry.size = size;
+	return true;
+}
+
+bool QParseDiskCacheStore::remove( const QUrl& url ) {
+	QMutexLocker locker( &mutex );
+	load();
+	QString key = keyOf( url );
+	if ( !entries.contains(key) ) return false;
+	removeEntry( key );
+	return true;
+}
+
+qint64 QParseDiskCacheStore::size() {
+	QMutexLocker locker( &mutex );
+	load();
+	return totalSize;
+}
+
+void QParseDiskCacheStore::clear() {
+	QMutexLocker locker( &mutex );
+	load();
+	foreach( QString key, entries.keys() ) {
+		removeEntry( key );
+	}
+}
+
+void QParseDiskCacheStore::load() {
+	if ( loaded ) return;
+	loaded = true;
+	QDir dir( directory );
+	if ( !dir.exists() ) {
+		dir.mkpath( "." );
+		return;
+	}
+	QFileInfoList files = dir.entryInfoList( QStringList() << "*.d", QDir::Files );
+	foreach( QFileInfo file, files ) {
+		Entry entry;
+		entry.size = file.size();
+		entry.lastUsed = file.lastModified().toMSecsSinceEpoch();
+		entries[file.fileName()] = entry;
+		totalSize += entry.size;
+	}
+	qparseDebug( qparseCache ) << "http cache loaded" << entries.size() << "entries" << totalSize << "bytes";
+	evict();
+}
+
+QString QParseDiskCacheStore::keyOf( const QUrl& url ) {
+	QByteArray hash = QCryptographicHash::hash( normalizedUrl(url).toEncoded(), QCryptographicHash::Sha1 );
+	return QString::fromLatin1( hash.toHex() )+".d";
+}
+
+bool QParseDiskCacheStore::readEntry( QString key, const QUrl& url, QNetworkCacheMetaData* metaData, QByteArray* data ) const {
+	QFile file( directory+"/"+key );
+	if ( !file.open( QIODevice::ReadOnly ) ) return false;
+	QDataStream stream( &file );
+	stream.setVersion( QDataStream::Qt_5_0 );
+	quint32 magic, version;
+	QNetworkCacheMetaData stored;
+	stream >> magic >> version;
+	if ( magic != entryMagic || version != entryVersion ) return false;
+	stream >> stored;
+	// the url is checked against the collisions of the hash
+	if ( stream.status() != QDataStream::Ok || normalizedUrl(stored.url()) != normalizedUrl(url) ) return false;
+	if ( data ) {
+		stream >> *data;
+		if ( stream.status() != QDataStream::Ok ) return false;
+	}
+	if ( metaData ) {
+		*metaData = stored;
+	}
+	return true;
+}
+
+bool QParseDiskCacheStore::writeEntry( QString key, const QNetworkCacheMetaData& metaData, const QByteArray& data ) const {
+	QDir().mkpath( directory );
+	// the entry is replaced only when completely written
+	QSaveFile file( directory+"/"+key );
+	if ( !file.open( QIODevice::WriteOnly ) ) {
+		qparseWarning( qparseCache ) << "http cache: cannot write" << file.fileName();
+		return false;
+	}
+	QDataStream stream( &file );
+	stream.setVersion( QDataStream::Qt_5_0 );
+	stream << entryMagic << entryVersion << metaData << data;
+	return stream.status() == QDataStream::Ok && file.commit();
+}
+
+void QParseDiskCacheStore::removeEntry( QString key ) {
+	totalSize -= entries.take( key ).size;
+	QFile::remove( directory+"/"+key );
+}
+
+void QParseDiskCacheStore::evict() {
+	if ( totalSize <= maximumSize ) return;
+	QList< QPair<qint64, QString> > byAge;
+	foreach( QString key, entries.keys() ) {
+		byAge << qMakePair( entries[key].lastUsed, key );
+	}
+	std::sort( byAge.begin(), byAge.end() );
+	qint64 target = qint64( maximumSize*evictionTarget );
+	int evicted = 0;
+	for( int i=0; i<byAge.size() && totalSize > target; i++ ) {
+		removeEntry( byAge[i].second );
+		evicted++;
+	}
+	qparseDebug( qparseCache ) << "http cache evicted" << evicted << "entries, size now" << totalSize;
+}
+
+QParseDiskCache::QParseDiskCache( QParse* client, QObject* parent )
+	: QAbstractNetworkCache(parent)
+	, store(client->getHttpCache())
+	, inserting() {
+}
+
+QParseDiskCache::~QParseDiskCache() {
+	qDeleteAll( inserting.keys() );
+}
+
+QNetworkCacheMetaData QParseDiskCache::metaData( const QUrl& url ) {
+	return store->metaData( url );
+}
+
+void QParseDiskCache::updateMetaData( const QNetworkCacheMetaData& metaData ) {
+	store->updateMetaData( metaData );
+}
+
+QIODevice* QParseDiskCache::data( const QUrl& url ) {
+	bool ok;
+	QByteArray data = store->data( url, &ok );
+	if ( !ok ) return NULL;
+	// the caller takes the ownership
+	QBuffer* buffer = new QBuffer();
+	buffer->setData( data );
+	buffer->open( QIODevice::ReadOnly );
+	return buffer;
+}
+
+bool QParseDiskCache::remove( const QUrl& url ) {
+	// drop the download of the same url, if any
+	foreach( QIODevice* device, inserting.keys() ) {
+		if ( normalizedUrl(inserting[device].url()) == normalizedUrl(url) ) {
+			inserting.remove( device );
+			delete device;
+		}
+	}
+	return store->remove( url );
+}
+
+qint64 QParseDiskCache::cacheSize() const {
+	return store->size();
+}
+
+QIODevice* QParseDiskCache::prepare( const QNetworkCacheMetaData& metaData ) {
+	if ( !metaData.isValid() || !metaData.url().isValid() || !metaData.saveToDisk() ) return NULL;
+	// don't download into memory what would not fit into the cache anyway
+	foreach( QNetworkCacheMetaData::RawHeader header, metaData.rawHeaders() ) {
+		if ( header.first.toLower() == "content-length" && header.second.toLongLong() > store->getMaximumSize() ) {
+			return NULL;
+		}
+	}
+	QBuffer* buffer = new QBuffer();
+	buffer->open( QIODevice::ReadWrite );
+	inserting[buffer] = metaData;
+	return buffer;
+}
+
+void QParseDiskCache::insert( QIODevice* device ) {
+	if ( !inserting.contains(device) ) return;
+	QNetworkCacheMetaData metaData = inserting.take( device );
+	store->insert( metaData, static_cast<QBuffer*>(device)->data() );
+	delete device;
+}
+
+void QParseDiskCache::clear() {
+	qDeleteAll( inserting.keys() );
+	inserting.clear();
+	store->clear();
+}
+
+QParseNetworkAccessManagerFactory::QParseNetworkAccessManagerFactory( QParse* client )
+	: client(client) {
+}
+
+QNetworkAccessManager* QParseNetworkAccessManagerFactory::create( QObject* parent ) {
+	QNetworkAccessManager* net = new QNetworkAccessManager(parent);
+	net->setCache( new QParseDiskCache( client ) );
+	return net;
+}
@@ -0,0 +1,139 @@
+#ifndef QPARSEDISKCACHE_H
+#define QPARSEDISKCACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QAbstractNetworkCache>
+#include <QNetworkCacheMetaData>
+#include <QQmlNetworkAccessManagerFactory>
+
+class QParse;
+class QParseStats;
+class QBuffer;
+
+/*! \internal The HTTP cache of a client, shared by all its QParseDiskCache
+ *
+ *  The entries are files in the http sub-directory of the cache of the client,
+ *  each one with the metadata and the body of a reply; the index in memory keeps
+ *  only their sizes and when they were used, and it's built from the directory
+ *  on the first use, so the creation of the client does not touch the disk
+ *
+ *  When the entries exceed the maximum size, the least recently used ones are
+ *  removed down to 90% of it, so the eviction does not run on every insert
+ *
+ *  It's thread-safe, the network managers of any thread use it
+ *
+ *  \warning Never create by yourself, it's created by QParse
+ */
+class QParseDiskCacheStore : public QObject {
+	Q_OBJECT
+public:
+	QParseDiskCacheStore( QString directory, QParseStats* stats, QObject* parent=0 );
+	//! the maximum size in bytes of all the entries
+	qint64 getMaximumSize() const;
+	void setMaximumSize( qint64 value );
+	//! return the metadata cached for url; not valid if not cached
+	QNetworkCacheMetaData metaData( const QUrl& url );
+	/*! return the body cached for url
+	 *  \param ok set to false if not cached or the entry is corrupted
+	 */
+	QByteArray data( const QUrl& url, bool* ok );
+	//! add or replace the entry of the url of metaData
+	void insert( const QNetworkCacheMetaData& metaData, const QByteArray& data );
+	//! replace the metadata of the entry, keeping the body; return false if not cached
+	bool updateMetaData( const QNetworkCacheMetaData& metaData );
+	//! return false if url was not cached
+	bool remove( const QUrl& url );
+	//! the size in bytes of all the entries
+	qint64 size();
+	//! remove all the entries
+	void clear();
+private:
+	//! an entry of the index
+	struct Entry {
+		Entry() : size(0), lastUsed(0) { }
+		qint64 size;
+		//! the milliseconds since epoch of the last hit (of the write, after a restart)
+		qint64 lastUsed;
+	};
+	//! build the index from the directory, if not done yet; the caller must hold mutex
+	void load();
+	//! return the file name (without directory) of the entry of url
+	static QString keyOf( const QUrl& url );
+	/*! read the entry from the file; the body is read only if data is not NULL
+	 *  \return false if the file is missing or corrupted
+	 */
+	bool readEntry( QString key, const QUrl& url, QNetworkCacheMetaData* metaData, QByteArray* data ) const;
+	bool writeEntry( QString key, const QNetworkCacheMetaData& metaData, const QByteArray& data ) const;
+	//! remove the entry from the index and from the disk; the caller must hold mutex
+	void removeEntry( QString key );
+	//! remove the least recently used entries while over the maximum size; the caller must hold mutex
+	void evict();
+
+	mutable QMutex mutex;
+	QString directory;
+	QParseStats* stats;
+	qint64 maximumSize;
+	//! true when the index has been built from the directory
+	bool loaded;
+	//! the entries indexed by file name
+	QHash<QString, Entry> entries;
+	qint64 totalSize;
+};
+
+/*! An HTTP cache for any QNetworkAccessManager, stored into the cache of a QParse client
+ *
+ *  The network managers of the app (QML images, web services other than PARSE, ...)
+ *  can use it instead of QNetworkDiskCache, so all the HTTP traffic of the app shares
+ *  the same disk budget (QParse::httpCacheSize) and eviction, and its hits and misses
+ *  are counted into the stats of the client (tier "http" of QParseStats)
+ *
+ *  The HTTP semantics are the ones of QNetworkAccessManager: the freshness of an entry
+ *  comes from Cache-Control, Expires and Last-Modified, the stale entries are revalidated
+ *  with If-None-Match and If-Modified-Since, and the replies marked no-store are not cached;
+ *  the cache also refuses the replies declaring a body bigger than its whole budget
+ *
+ *  A QNetworkAccessManager takes the ownership of its cache, so each manager needs its own
+ *  QParseDiskCache; they are lightweight, and all of a client share the same entries
+ *  \code
+ *  QNetworkAccessManager* net = new QNetworkAccessManager();
+ *  net->setCache( new QParseDiskCache( QParse::instance() ) );
+ *  // or for the network managers of QML
+ *  engine->setNetworkAccessManagerFactory( new QParseNetworkAccessManagerFactory( QParse::instance() ) );
+ *  \endcode
+ *
+ *  \warning the client must outlive the network managers using its cache
+ */
+class QParseDiskCache : public QAbstractNetworkCache {
+	Q_OBJECT
+public:
+	QParseDiskCache( QParse* client, QObject* parent=0 );
+	~QParseDiskCache();
+	virtual QNetworkCacheMetaData metaData( const QUrl& url );
+	virtual void updateMetaData( const QNetworkCacheMetaData& metaData );
+	virtual QIODevice* data( const QUrl& url );
+	virtual bool remove( const QUrl& url );
+	virtual qint64 cacheSize() const;
+	virtual QIODevice* prepare( const QNetworkCacheMetaData& metaData );
+	virtual void insert( QIODevice* device );
+public slots:
+	virtual void clear();
+private:
+	QParseDiskCacheStore* store;
+	//! the bodies being downloaded, waiting for insert
+	QHash<QIODevice*, QNetworkCacheMetaData> inserting;
+};
+
+/*! It creates the network managers of QML with a QParseDiskCache of the client
+ *  \note the ownership is taken by the QQmlEngine
+ */
+class QParseNetworkAccessManagerFactory : public QQmlNetworkAccessManagerFactory {
+public:
+	QParseNetworkAccessManagerFactory( QParse* client );
+	virtual QNetworkAccessManager* create( QObject* parent );
+private:
+	QParse* client;
+};
+
+#endif // QPARSEDISKCACHE_H
@@ -0,0 +1,211 @@
+
+#include "qparsedispatcher.h"
+#include "qparsethrottle.h"
+#include "qparsereply.h"
+#include "qparsetransport.h"
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QMutexLocker>
+#include <QTimer>
+#ifndef QT_NO_SSL
+#include <QSslConfiguration>
+#endif
+
+QParseDispatcher::QParseDispatcher( QParse* parse )
+	: QObject(NULL)
+	, parse(parse)
+	, mutex()
+	, operationsQueue()
+	, operationsPending() {
+	// the factory may replace the network (like the replay of QParseReplay)
+	QQmlNetworkAccessManagerFactory* factory = QParse::getNetworkAccessManagerFactory();
+	if ( factory ) {
+		net = factory->create( this );
+	} else {
+		net = new QNetworkAccessManager(this);
+	}
+	QParseTransportFactory* transportFactory = QParse::getTransportFactory();
+	if ( transportFactory ) {
+		transport = transportFactory->create( this );
+		// the installation and the app config are still requested on the network
+		connect( net, &QNetworkAccessManager::finished, this, &QParseDispatcher::onRequestFinished );
+	} else {
+		// it forwards all the replies of net
+		transport = new QParseNetworkTransport( net, this );
+	}
+	connect( transport, &QParseTransport::finished, this, &QParseDispatcher::onRequestFinished );
+	// set the timer for processing the queue; it runs only while the queue is not empty
+	timer = new QTimer(this);
+	timer->setInterval(0);
+	timer->setSingleShot(false);
+	connect( timer, &QTimer::timeout, this, &QParseDispatcher::processOperationsQueue );
+	// requests submitted before QParse is ready are held until then
+	connect( parse, &QParse::readyChanged, this, &QParseDispatcher::start );
+	// the network queue waits for tokens or for the completion of requests in flight
+	networkTimer = new QTimer(this);
+	networkTimer->setSingleShot(true);
+	connect( networkTimer, &QTimer::timeout, this, &QParseDispatcher::sendNetworkQueue );
+	connect( parse->throttle, &QParseThrottle::released, this, &QParseDispatcher::sendNetworkQueue, Qt::QueuedConnection );
+#ifndef QT_NO_SSL
+	// each new TLS connection is a handshake; the requests sent without one reuse a connection
+	connect( net, &QNetworkAccessManager::encrypted, this, [this]() {
+		parse->statsHandshakes.ref();
+	});
+#endif
+}
+
+QNetworkAccessManager* QParseDispatcher::getNet() const {
+	return net;
+}
+
+QParseTransport* QParseDispatcher::getTransport() const {
+	return transport;
+}
+
+void QParseDispatcher::enqueue( QParse::OperationData* opdata ) {
+	QMutexLocker locker( &mutex );
+	operationsQueue.enqueue( opdata );
+	// the timer has to be started from the thread of the dispatcher
+	QMetaObject::invokeMethod( this, "start", Qt::QueuedConnection );
+}
+
+void QParseDispatcher::start() {
+	if ( !parse->isReady() || timer->isActive() ) return;
+	QMutexLocker locker( &mutex );
+	if ( !operationsQueue.isEmpty() ) {
+		timer->start();
+	}
+}
+
+void QParseDispatcher::shutdown() {
+	timer->stop();
+	networkTimer->stop();
+	// nothing has to reach the client anymore, also the replies aborted below
+	disconnect( parse, 0, this, 0 );
+	disconnect( parse->throttle, 0, this, 0 );
+	disconnect( net, 0, this, 0 );
+	disconnect( transport, 0, this, 0 );
+	QList<QParse::OperationData*> cancelled;
+	{
+		QMutexLocker locker( &mutex );
+		cancelled << operationsQueue;
+		operationsQueue.clear();
+	}
+	cancelled << networkQueue << retrying;
+	networkQueue.clear();
+	retrying.clear();
+	foreach( QNetworkReply* netReply, operationsPending.keys() ) {
+		cancelled << operationsPending.take( netReply );
+		netReply->abort();
+	}
+	foreach( QParse::OperationData* opdata, cancelled ) {
+		parse->cancelOperation( opdata );
+	}
+	deleteLater();
+}
+
+void QParseDispatcher::abort( QParseReply* reply ) {
+	QParse::OperationData* opdata = NULL;
+	{
+		QMutexLocker locker( &mutex );
+		for( int i=0; i<operationsQueue.size(); i++ ) {
+			if ( operationsQueue[i]->parseReply == reply ) {
+				opdata = operationsQueue.takeAt( i );
+				break;
+			}
+		}
+	}
+	for( int i=0; !opdata && i<networkQueue.size(); i++ ) {
+		if ( networkQueue[i]->parseReply == reply ) {
+			opdata = networkQueue.takeAt( i );
+		}
+	}
+	if ( opdata ) {
+		parse->cancelOperation( opdata );
+		return;
+	}
+	foreach( QNetworkReply* netReply, operationsPending.keys() ) {
+		if ( operationsPending[netReply]->parseReply == reply ) {
+			// the reply will be finished with the error on onRequestFinished
+			netReply->abort();
+			return;
+		}
+	}
+}
+
+void QParseDispatcher::prewarm( QUrl url, int connections, bool http2 ) {
+	// not used without SSL or before Qt 5.13
+	Q_UNUSED( http2 );
+	for( int i=0; i<connections; i++ ) {
+#ifndef QT_NO_SSL
+		if ( url.scheme() == "https" ) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+			// the requests reuse only the connections negotiated with the same protocols
+			QSslConfiguration sslConfig = QSslConfiguration::defaultConfiguration();
+			if ( http2 ) {
+				sslConfig.setAllowedNextProtocols( QList<QByteArray>()
+												   << QSslConfiguration::ALPNProtocolHTTP2
+												   << QSslConfiguration::NextProtocolHttp1_1 );
+			}
+			net->connectToHostEncrypted( url.host(), url.port(443), sslConfig, QString() );
+#else
+			net->connectToHostEncrypted( url.host(), url.port(443) );
+#endif
+			continue;
+		}
+#endif
+		net->connectToHost( url.host(), url.port(80) );
+	}
+}
+
+void QParseDispatcher::processOperationsQueue() {
+	// all the requests queued so far are processed, the network ones are throttled by send
+	QQueue<QParse::OperationData*> queued;
+	{
+		QMutexLocker locker( &mutex );
+		timer->stop();
+		queued.swap( operationsQueue );
+	}
+	while( !queued.isEmpty() ) {
+		parse->processOperationsQueue( this, queued.dequeue() );
+	}
+}
+
+void QParseDispatcher::send( QParse::OperationData* opdata ) {
+	// an aborted request waiting to be retried is never sent again
+	if ( opdata->parseReply->isAborted() ) {
+		parse->cancelOperation( opdata );
+		return;
+	}
+	networkQueue.enqueue( opdata );
+	sendNetworkQueue();
+}
+
+void QParseDispatcher::retry( QParse::OperationData* opdata, int delay ) {
+	retrying.append( opdata );
+	QTimer::singleShot( delay, this, [this, opdata]() {
+		if ( retrying.removeOne( opdata ) ) {
+			send( opdata );
+		}
+	});
+}
+
+void QParseDispatcher::sendNetworkQueue() {
+	while( !networkQueue.isEmpty() ) {
+		int waitMs;
+		if ( !parse->throttle->tryAcquire( &waitMs ) ) {
+			// when too many requests are in flight, the throttle signals the completion of one
+			if ( waitMs > 0 && (!networkTimer->isActive() || networkTimer->remainingTime() > waitMs) ) {
+				networkTimer->start( waitMs );
+			}
+			return;
+		}
+		parse->sendNetworkRequest( this, networkQueue.dequeue() );
+	}
+}
+
+void QParseDispatcher::onRequestFinished( QNetworkReply* reply ) {
+	parse->onRequestFinished( this, reply );
+	// the data has been taken, also by the requests sent again after being throttled
+	reply->deleteLater();
+}
@@ -0,0 +1,99 @@
+#ifndef QPARSEDISPATCHER_H
+#define QPARSEDISPATCHER_H
+
+#include <QObject>
+#include <QMap>
+#include <QQueue>
+#include <QMutex>
+#include <QUrl>
+#include "qparse.h"
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class QTimer;
+class QParseReply;
+class QParseTransport;
+
+/*! It sends the requests submitted to QParse from a thread
+ *
+ *  QParse creates one dispatcher for each thread that submits requests,
+ *  and each dispatcher has its own QNetworkAccessManager; so requests from
+ *  worker threads never pass through the main thread, and their replies
+ *  are processed and delivered on the thread that submitted them
+ *
+ *  All the queued requests are processed at once; the ones not served by the
+ *  cache are sent over the network as fast as the throttle of QParse allows
+ *
+ *  The logic of processing requests and replies is into QParse
+ *  (see QParse::processOperationsQueue and QParse::onRequestFinished)
+ *
+ *  \warning Never create by yourself, it's created by QParse
+ */
+class QParseDispatcher : public QObject {
+	Q_OBJECT
+public:
+	QParseDispatcher( QParse* parse );
+	//! return the network manager of this thread
+	QNetworkAccessManager* getNet() const;
+	//! return the transport sending the requests of this thread (see QParse::setTransportFactory)
+	QParseTransport* getTransport() const;
+	//! add the operation to the queue; it's safe to call it from any thread
+	void enqueue( QParse::OperationData* opdata );
+	/*! add the operation to the queue of the network requests
+	 *  The requests are sent when the throttle of QParse allows it
+	 *  \note it's called on the thread of the dispatcher
+	 */
+	void send( QParse::OperationData* opdata );
+	//! send again the operation after delay milliseconds
+	void retry( QParse::OperationData* opdata, int delay );
+public slots:
+	//! start processing the queue, if QParse is ready
+	void start();
+	/*! finish all the requests with QNetworkReply::OperationCanceledError and delete
+	 *  the dispatcher later; called by QParse when the client is destroyed
+	 */
+	void shutdown();
+	/*! cancel the request of the reply
+	 *  It's removed from the queues, or its network request is aborted if already sent
+	 */
+	void abort( QParseReply* reply );
+	/*! open the connections to the host of url in advance
+	 *  The requests sent later will use them without waiting for DNS, TCP and TLS
+	 *  \param http2 if true the TLS connections offer HTTP/2, like the requests (Qt 5.13 or later)
+	 */
+	void prewarm( QUrl url, int connections, bool http2 );
+private slots:
+	void processOperationsQueue();
+	//! send the network requests allowed by the throttle
+	void sendNetworkQueue();
+	void onRequestFinished( QNetworkReply* reply );
+private:
+	friend class QParse;
+	Q_DISABLE_COPY( QParseDispatcher )
+
+	//! the QParse using this dispatcher
+	QParse* parse;
+	//! the newtork manager for sending requests to cloud backend
+	QNetworkAccessManager* net;
+	//! the transport of the requests to PARSE; the network of net by default
+	QParseTransport* transport;
+	//! protect operationsQueue from concurrent enqueue
+	QMutex mutex;
+	/*! the queue of the operation to process
+	 *  A parseRequest will be put in this queue and as soon as possible
+	 *  will be processed and created a netRequest to send over internet
+	 */
+	QQueue<QParse::OperationData*> operationsQueue;
+	//! the map of operation sent to Parse waiting for a netReply to process
+	QMap<QNetworkReply*, QParse::OperationData*> operationsPending;
+	//! Timer for triggering the execution of processOperationsQueue()
+	QTimer* timer;
+	//! the operations waiting for the throttle for being sent over the network
+	QQueue<QParse::OperationData*> networkQueue;
+	//! Timer for sending the network queue when the next token of the throttle is available
+	QTimer* networkTimer;
+	//! the operations waiting to be sent again (see retry)
+	QList<QParse::OperationData*> retrying;
+};
+
+#endif // QPARSEDISPATCHER_H
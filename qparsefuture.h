@@ -0,0 +1,71 @@
+#ifndef QPARSEFUTURE_H
+#define QPARSEFUTURE_H
+
+#include <QObject>
+#include <QFuture>
+#include <QFutureInterface>
+#include <QFutureWatcher>
+#include <QSharedPointer>
+#include <QList>
+#include "qparsereply.h"
+
+//! \file This file contains the helpers for composing the futures returned by QParse
+
+/*! call the function with the result of the future as soon as it's finished
+ *  \param context the function is called on the thread of context, and never if context is destroyed before
+ *
+ *  \code
+ *  qParseThen( QParse::instance()->getAsync(request), this, [this](QParseResult result) {
+ *      ...
+ *  });
+ *  \endcode
+ */
+template<typename T, typename Function>
+void qParseThen( QFuture<T> future, QObject* context, Function function ) {
+	QFutureWatcher<T>* watcher = new QFutureWatcher<T>(context);
+	QObject::connect( watcher, &QFutureWatcher<T>::finished, context, [watcher, function]() {
+		function( watcher->result() );
+		watcher->deleteLater();
+	});
+	watcher->setFuture( future );
+}
+
+/*! return a future finished when all the futures are finished;
+ *  its result is the list of all the results in the same order
+ *  \note the requests are already running in parallel when their futures are created,
+ *        so submit all independent requests first, then wait for them with this
+ *  \param context the object on which thread the futures are watched
+ */
+template<typename T>
+QFuture< QList<T> > qParseWhenAll( QList< QFuture<T> > futures, QObject* context ) {
+	//! the shared state of all the watchers
+	struct State {
+		QFutureInterface< QList<T> > futureInterface;
+		QList< QFuture<T> > futures;
+		int remaining;
+	};
+	QSharedPointer<State> state( new State );
+	state->futures = futures;
+	state->remaining = futures.size();
+	state->futureInterface.reportStarted();
+	QFuture< QList<T> > all = state->futureInterface.future();
+	if ( futures.isEmpty() ) {
+		state->futureInterface.reportResult( QList<T>() );
+		state->futureInterface.reportFinished();
+		return all;
+	}
+	foreach( QFuture<T> future, futures ) {
+		qParseThen( future, context, [state](T) {
+			if ( --state->remaining > 0 ) return;
+			QList<T> results;
+			foreach( QFuture<T> done, state->futures ) {
+				results << done.result();
+			}
+			state->futureInterface.reportResult( results );
+			state->futureInterface.reportFinished();
+		});
+	}
+	return all;
+}
+
+#endif // QPARSEFUTURE_H
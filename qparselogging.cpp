@@ -0,0 +1,23 @@
+
+#include "qparselogging.h"
+#include <QJsonDocument>
+
+Q_LOGGING_CATEGORY( qparseNetwork, "qparse.network", QtWarningMsg )
+Q_LOGGING_CATEGORY( qparseCache, "qparse.cache", QtWarningMsg )
+Q_LOGGING_CATEGORY( qparseInstallation, "qparse.installation", QtWarningMsg )
+Q_LOGGING_CATEGORY( qparseQuery, "qparse.query", QtWarningMsg )
+
+QByteArray qparseLoggedPayload( const QByteArray& data ) {
+	if ( data.size() <= qparseMaxLoggedPayload ) {
+		return data;
+	}
+	return data.left( qparseMaxLoggedPayload ) + "... (" + QByteArray::number( data.size() ) + " bytes)";
+}
+
+QByteArray qparseLoggedPayload( const QJsonObject& data ) {
+	return qparseLoggedPayload( QJsonDocument(data).toJson( QJsonDocument::Compact ) );
+}
+
+QByteArray qparseLoggedPayload( const QJsonArray& data ) {
+	return qparseLoggedPayload( QJsonDocument(data).toJson( QJsonDocument::Compact ) );
+}
@@ -0,0 +1,47 @@
+#ifndef QPARSELOGGING_H
+#define QPARSELOGGING_H
+
+#include <QLoggingCategory>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QJsonArray>
+
+/*! The logging categories of QParse
+ *
+ *    qparse.network: the requests sent to PARSE and their replies
+ *    qparse.cache: the cache directory, the bundled pack and the outbox
+ *    qparse.installation: the Installation row of the device
+ *    qparse.query: the queries, the batches and the prefetch of pointers
+ *
+ *  The debug messages are disabled by default, enable them with the logging rules:
+ *  \code
+ *  QT_LOGGING_RULES="qparse.network.debug=true;qparse.cache.debug=true"
+ *  \endcode
+ *  The arguments of a disabled message are never evaluated, so nothing is formatted
+ *
+ *  Defining QPARSE_NO_LOGGING at build time removes all the messages from the code
+ */
+Q_DECLARE_LOGGING_CATEGORY( qparseNetwork )
+Q_DECLARE_LOGGING_CATEGORY( qparseCache )
+Q_DECLARE_LOGGING_CATEGORY( qparseInstallation )
+Q_DECLARE_LOGGING_CATEGORY( qparseQuery )
+
+#ifdef QPARSE_NO_LOGGING
+#define qparseDebug( category ) QT_NO_QDEBUG_MACRO()
+#define qparseWarning( category ) QT_NO_QDEBUG_MACRO()
+#else
+#define qparseDebug( category ) qCDebug( category )
+#define qparseWarning( category ) qCWarning( category )
+#endif
+
+//! the maximum number of bytes of a payload written on the log
+static const int qparseMaxLoggedPayload = 512;
+
+/*! return the payload truncated to qparseMaxLoggedPayload bytes, for the log messages
+ *  \note use it only as argument of the logging macros, so it's called only when the message is enabled
+ */
+QByteArray qparseLoggedPayload( const QByteArray& data );
+QByteArray qparseLoggedPayload( const QJsonObject& data );
+QByteArray qparseLoggedPayload( const QJsonArray& data );
+
+#endif // QPARSELOGGING_H
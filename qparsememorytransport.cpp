@@ -0,0 +1,170 @@
+
+#include "qparsememorytransport.h"
+#include <QTimer>
+
+QParseMemoryTransport::QParseMemoryTransport( Handler handler, Settings settings, QObject* parent )
+	: QParseTransport(parent)
+	, handler(handler)
+	, settings(settings)
+	, state(settings.seed ? settings.seed : 1)
+	, requests(0) {
+}
+
+QNetworkReply* QParseMemoryTransport::send( QByteArray method, const QNetworkRequest& request, QByteArray body ) {
+	requests++;
+	// the random numbers are taken always in the same order, so the sequence depends only on the requests
+	bool failed = nextRandom() < settings.failureRate;
+	int jitter = int( nextRandom()*(settings.jitter+1) );
+	Response response;
+	if ( failed ) {
+		response.status = 0;
+		response.headers.clear();
+		response.error = settings.failureError;
+	} else if ( handler ) {
+		response = handler( method, request, body );
+	} else {
+		response.status = 404;
+		response.error = QNetworkReply::ContentNotFoundError;
+		response.body = "{\"code\":101,\"error\":\"no handler\"}";
+	}
+	if ( response.latency < 0 ) {
+		response.latency = settings.latency;
+	}
+	response.latency += jitter;
+	if ( response.duration >= 0 ) {
+		response.duration += jitter;
+	}
+	// the dispatcher deletes the reply when it has handled it
+	QNetworkReply* reply = new QParseMemoryReply( QParseMemoryReply::toOperation(method), request, response, this );
+	connect( reply, &QNetworkReply::finished, this, [this, reply]() {
+		emit finished( reply );
+	});
+	return reply;
+}
+
+int QParseMemoryTransport::getRequests() const {
+	return requests;
+}
+
+double QParseMemoryTransport::nextRandom() {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state / 4294967296.0;
+}
+
+QParseMemoryTransportFactory::QParseMemoryTransportFactory( QParseMemoryTransport::Handler handler,
+															QParseMemoryTransport::Settings settings )
+	: handler(handler)
+	, settings(settings) {
+}
+
+QParseTransport* QParseMemoryTransportFactory::create( QObject* parent ) {
+	return new QParseMemoryTransport( handler, settings, parent );
+}
+
+QParseMemoryReply::QParseMemoryReply( QNetworkAccessManager::Operation op, const QNetworkRequest& request,
+									  QParseMemoryTransport::Response response, QObject* parent )
+	: QNetworkReply(parent)
+	, response(response)
+	, received(0)
+	, offset(0)
+	, chunksDelivered(0)
+	, headersReceived(false) {
+	setOperation( op );
+	setRequest( request );
+	setUrl( request.url() );
+	open( QIODevice::ReadOnly | QIODevice::Unbuffered );
+	int latency = qMax( 0, response.latency );
+	int duration = qMax( latency, response.duration );
+	int chunks = qMax( 1, response.chunks );
+	QTimer::singleShot( latency, this, SLOT(onHeaders()) );
+	for( int i=1; i<=chunks; i++ ) {
+		QTimer::singleShot( latency + (duration-latency)*i/chunks, this, SLOT(onChunk()) );
+	}
+}
+
+QNetworkAccessManager::Operation QParseMemoryReply::toOperation( QByteArray method ) {
+	if ( method == "GET" ) {
+		return QNetworkAccessManager::GetOperation;
+	} else if ( method == "POST" ) {
+		return QNetworkAccessManager::PostOperation;
+	} else if ( method == "PUT" ) {
+		return QNetworkAccessManager::PutOperation;
+	} else if ( method == "DELETE" ) {
+		return QNetworkAccessManager::DeleteOperation;
+	} else if ( method == "HEAD" ) {
+		return QNetworkAccessManager::HeadOperation;
+	}
+	return QNetworkAccessManager::CustomOperation;
+}
+
+void QParseMemoryReply::abort() {
+	if ( isFinished() ) return;
+	failWith( OperationCanceledError, "Operation canceled" );
+	setFinished( true );
+	emit finished();
+}
+
+void QParseMemoryReply::failWith( NetworkError code, QString message ) {
+	setError( code, message );
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+	emit errorOccurred( code );
+#else
+	emit error( code );
+#endif
+}
+
+qint64 QParseMemoryReply::bytesAvailable() const {
+	return received - offset + QNetworkReply::bytesAvailable();
+}
+
+bool QParseMemoryReply::isSequential() const {
+	return true;
+}
+
+qint64 QParseMemoryReply::readData( char* data, qint64 maxSize ) {
+	if ( offset >= received ) {
+		return isFinished() ? -1 : 0;
+	}
+	qint64 size = qMin( maxSize, qint64(received) - offset );
+	memcpy( data, response.body.constData()+offset, size_t(size) );
+	offset += size;
+	return size;
+}
+
+void QParseMemoryReply::onHeaders() {
+	if ( isFinished() || headersReceived ) return;
+	headersReceived = true;
+	if ( response.status > 0 ) {
+		setAttribute( QNetworkRequest::HttpStatusCodeAttribute, response.status );
+	}
+	for( int i=0; i<response.headers.size(); i++ ) {
+		setRawHeader( response.headers[i].first, response.headers[i].second );
+	}
+	emit metaDataChanged();
+}
+
+void QParseMemoryReply::onChunk() {
+	if ( isFinished() ) return;
+	onHeaders();
+	int chunks = qMax( 1, response.chunks );
+	chunksDelivered++;
+	int size = response.body.size();
+	received = int( qint64(size)*chunksDelivered/chunks );
+	bool truncated = response.truncateAt >= 0 && received >= response.truncateAt;
+	if ( truncated ) {
+		received = qMin( received, response.truncateAt );
+	}
+	emit downloadProgress( received, size );
+	emit readyRead();
+	if ( truncated ) {
+		failWith( RemoteHostClosedError, "Connection closed" );
+	} else if ( chunksDelivered < chunks ) {
+		return;
+	} else if ( response.error != NoError ) {
+		failWith( response.error, QString("Error replied from memory, HTTP status %1").arg(response.status) );
+	}
+	setFinished( true );
+	emit finished();
+}
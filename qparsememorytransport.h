@@ -0,0 +1,142 @@
+#ifndef QPARSEMEMORYTRANSPORT_H
+#define QPARSEMEMORYTRANSPORT_H
+
+#include <QList>
+#include <QPair>
+#include <QNetworkReply>
+#include <QNetworkAccessManager>
+#include <functional>
+#include "qparsetransport.h"
+
+/*! A transport replying from memory, without sockets, for deterministic tests and benchmarks
+ *  of the dispatchers, the throttle and the cache
+ *
+ *  The replies are returned by a handler; the transport delays them by a latency and
+ *  it can inject failures. The latency jitter and the failures are chosen by a pseudo-random
+ *  generator with a fixed seed, so the same requests get always the same timings, errors
+ *  and order of completion (the jitter makes the replies complete out of order)
+ *
+ *  \code
+ *  QParseMemoryTransport::Settings settings;
+ *  settings.latency = 50;
+ *  settings.jitter = 30;
+ *  settings.failureRate = 0.05;
+ *  QParseMemoryTransportFactory factory( []( QByteArray method, const QNetworkRequest& request, QByteArray body ) {
+ *      QParseMemoryTransport::Response response;
+ *      response.body = "{\"results\":[]}";
+ *      return response;
+ *  }, settings );
+ *  QParse::setTransportFactory( &factory );
+ *  \endcode
+ */
+class QParseMemoryTransport : public QParseTransport {
+	Q_OBJECT
+public:
+	//! the reply to a request
+	struct Response {
+		Response()
+			: status(200)
+			, headers()
+			, body()
+			, error(QNetworkReply::NoError)
+			, latency(-1)
+			, duration(-1)
+			, chunks(1)
+			, truncateAt(-1) {
+			headers << qMakePair( QByteArray("Content-Type"), QByteArray("application/json") );
+		}
+		//! the HTTP status code
+		int status;
+		QList< QPair<QByteArray, QByteArray> > headers;
+		QByteArray body;
+		//! the error of the reply; it must be set for the HTTP errors too, like the network does
+		QNetworkReply::NetworkError error;
+		//! the milliseconds to the headers; -1 means the latency of the transport
+		int latency;
+		//! the milliseconds to the end of the body; -1 means at the headers
+		int duration;
+		//! the body arrives in this number of parts, evenly spread from latency to duration
+		int chunks;
+		//! if not negative, the connection is closed after these bytes of the body
+		int truncateAt;
+	};
+	/*! it returns the reply to the request
+	 *  \note it's called from the threads of the dispatchers
+	 */
+	typedef std::function<Response( QByteArray method, const QNetworkRequest& request, QByteArray body )> Handler;
+	//! the behavior of the transport
+	struct Settings {
+		Settings()
+			: latency(0)
+			, jitter(0)
+			, failureRate(0)
+			, failureError(QNetworkReply::TemporaryNetworkFailureError)
+			, seed(1) { }
+		//! the milliseconds to the headers of the replies without their own latency
+		int latency;
+		//! a pseudo-random delay up to these milliseconds added to each reply
+		int jitter;
+		//! the fraction of the requests failing with failureError instead of calling the handler
+		double failureRate;
+		QNetworkReply::NetworkError failureError;
+		//! the seed of the pseudo-random generator
+		quint32 seed;
+	};
+	QParseMemoryTransport( Handler handler, Settings settings, QObject* parent=0 );
+	virtual QNetworkReply* send( QByteArray method, const QNetworkRequest& request, QByteArray body );
+	//! the number of requests sent so far
+	int getRequests() const;
+private:
+	//! return the next pseudo-random number between 0 and 1 (xorshift, the same on all platforms)
+	double nextRandom();
+
+	Handler handler;
+	Settings settings;
+	quint32 state;
+	int requests;
+};
+
+//! It creates a QParseMemoryTransport for each dispatcher, all with the same handler and settings
+class QParseMemoryTransportFactory : public QParseTransportFactory {
+public:
+	QParseMemoryTransportFactory( QParseMemoryTransport::Handler handler,
+								  QParseMemoryTransport::Settings settings=QParseMemoryTransport::Settings() );
+	virtual QParseTransport* create( QObject* parent );
+private:
+	QParseMemoryTransport::Handler handler;
+	QParseMemoryTransport::Settings settings;
+};
+
+/*! A reply built from memory (see QParseMemoryTransport and QParseReplay)
+ *  The headers arrive after the latency of the response and the body up to its duration
+ */
+class QParseMemoryReply : public QNetworkReply {
+	Q_OBJECT
+public:
+	QParseMemoryReply( QNetworkAccessManager::Operation op, const QNetworkRequest& request,
+					   QParseMemoryTransport::Response response, QObject* parent=0 );
+	//! return the operation of the method (GET, POST, ...)
+	static QNetworkAccessManager::Operation toOperation( QByteArray method );
+	virtual void abort();
+	virtual qint64 bytesAvailable() const;
+	virtual bool isSequential() const;
+protected:
+	virtual qint64 readData( char* data, qint64 maxSize );
+private slots:
+	void onHeaders();
+	//! deliver the next part of the body, and finish after the last one
+	void onChunk();
+private:
+	//! set the error and emit its signal (errorOccurred since Qt 5.15)
+	void failWith( NetworkError code, QString message );
+
+	QParseMemoryTransport::Response response;
+	//! the bytes of the body delivered so far
+	int received;
+	//! the bytes of the body read so far
+	qint64 offset;
+	int chunksDelivered;
+	bool headersReceived;
+};
+
+#endif // QPARSEMEMORYTRANSPORT_H
@@ -2,7 +2,12 @@
 #include "qparse.h"
 #include "qparserequest.h"
 #include "qparsereply.h"
-#include <QDebug>
+#include "qparsebatch.h"
+#include "qparseprefetch.h"
+#include "qparseoutbox.h"
+#include "qparsestats.h"
+#include <QElapsedTimer>
+#include <QMetaProperty>
 
 QParseObject::QParseObject( QObject* parent )
 	: QObject(parent)
@@ -10,7 +15,9 @@ QParseObject::QParseObject( QObject* parent )
 	, createdAt()
 	, updatedAt()
 	, updating(false)
-	, saving(false) {
+	, saving(false)
+	, localId()
+	, client(NULL) {
 }
 
 QParseObject::QParseObject(QJsonObject jsonData, QObject* parent)
@@ -19,7 +26,9 @@ QParseObject::QParseObject(QJsonObject jsonData, QObject* parent)
 	, createdAt()
 	, updatedAt()
 	, updating(false)
-	, saving(false) {
+	, saving(false)
+	, localId()
+	, client(NULL) {
 	objectId = jsonData["objectId"].toString();
 	createdAt = QParseDate( jsonData["createdAt"].toString() );
 	updatedAt = QParseDate( jsonData["updatedAt"].toString() );
@@ -37,16 +46,37 @@ QParseDate QParseObject::getUpdatedAt() const {
 	return updatedAt;
 }
 
+QString QParseObject::getLocalId() const {
+	return localId;
+}
+
+void QParseObject::setLocalId( QString value ) {
+	if ( localId == value ) return;
+	localId = value;
+	emit localIdChanged( localId );
+}
+
+QParse* QParseObject::getClient() const {
+	return client ? client : QParse::instance();
+}
+
+void QParseObject::setClient( QParse* value ) {
+	client = value;
+}
+
 bool QParseObject::isUpdating() {
 	return updating;
 }
 
 void QParseObject::update() {
 	if ( objectId.isEmpty() || updating || saving ) return;
+	// the data on PARSE is older than the one committed on the outbox
+	if ( getClient()->getOutbox()->isPending( this ) ) return;
 	updating = true;
-	QParseRequest* update = new QParseRequest(parseClassName());
+	QParseRequest* update = new QParseRequest(parseClassName(), getClient());
 	update->setParseObject( this );
-	QParseReply* reply = QParse::instance()->get( update );
+	QParseReply* reply = getClient()->get( update );
+	reply->setOwner( this );
 	connect( reply, &QParseReply::finished, this, &QParseObject::onUpdateReply );
 }
 
@@ -56,20 +86,47 @@ bool QParseObject::isSaving() {
 
 void QParseObject::save() {
 	if ( updating || saving ) return;
+	if ( getClient()->getOfflineWrites() ) {
+		// committed locally, the outbox will send it to PARSE
+		getClient()->getOutbox()->save( this );
+		emit savingDone();
+		return;
+	}
 	saving = true;
-	QParseRequest* save = new QParseRequest(parseClassName());
+	QParseRequest* save = new QParseRequest(parseClassName(), getClient());
 	save->setParseObject( this );
 	QParseReply* reply;
 	if ( objectId.isEmpty() ) {
 		// create the object
-		reply = QParse::instance()->post( save );
+		reply = getClient()->post( save );
 	} else {
 		// updated the object
-		reply = QParse::instance()->put( save );
+		reply = getClient()->put( save );
 	}
 	connect( reply, &QParseReply::finished, this, &QParseObject::onSaveReply );
 }
 
+QParseBatch* QParseObject::saveAll( QList<QParseObject*> objects, QParse* client ) {
+	return new QParseBatch( QParseBatch::Save, objects, client );
+}
+
+QParseBatch* QParseObject::deleteAll( QList<QParseObject*> objects, QParse* client ) {
+	return new QParseBatch( QParseBatch::Delete, objects, client );
+}
+
+QParseBatch* QParseObject::fetchAll( QList<QParseObject*> objects, QParse* client ) {
+	return new QParseBatch( QParseBatch::Fetch, objects, client );
+}
+
+QParsePrefetch* QParseObject::prefetchAll( QList<QParseObject*> objects, int depth, QParse* client ) {
+	return new QParsePrefetch( objects, depth, client );
+}
+
+bool QParseObject::isFetched() const {
+	// every object got from PARSE has the createdAt
+	return createdAt.toDateTime().isValid();
+}
+
 QJsonObject QParseObject::toJson( bool onlyChanged ) {
 	Q_UNUSED( onlyChanged )
 	QJsonObject data;
@@ -100,7 +157,70 @@ QJsonObject QParseObject::getJsonPointer() {
 	return pointer;
 }
 
+void QParseObject::fromJson( QJsonObject jsonData, bool onlyPointers ) {
+	if ( jsonData.contains("objectId") && !onlyPointers ) {
+		objectId = jsonData["objectId"].toString();
+	}
+	if ( jsonData.contains("createdAt") && !onlyPointers ) {
+		createdAt = QParseDate( jsonData["createdAt"].toString() );
+		emit createdAtChanged( createdAt );
+	}
+	if ( jsonData.contains("updatedAt") && !onlyPointers ) {
+		updatedAt = QParseDate( jsonData["updatedAt"].toString() );
+		emit updatedAtChanged( updatedAt );
+	}
+	foreach( QString property, parseProperties() ) {
+		if ( !jsonData.contains(property) ) continue;
+		QJsonValue value = jsonData[property];
+		QString type = value.toObject()["__type"].toString();
+		// handle PARSE specific data
+		if ( type == "Pointer" || type == "Object" ) {
+			// pointer to Parse object, with all its data when included
+			QJsonObject pointerData = value.toObject();
+			QParseObject* pointer = this->property( property.toLatin1().data() ).value<QParseObject*>();
+			if ( !pointer || pointer->getObjectId() != pointerData["objectId"].toString() ) {
+				// create the object of the type of the property
+				QMetaProperty metaProperty = metaObject()->property( metaObject()->indexOfProperty( property.toLatin1().data() ) );
+				const QMetaObject* pointerMetaObject = QMetaType::metaObjectForType( metaProperty.userType() );
+				if ( !pointerMetaObject ) continue;
+				pointer = qobject_cast<QParseObject*>( pointerMetaObject->newInstance( Q_ARG(QJsonObject, pointerData), Q_ARG(QObject*, this) ) );
+				if ( !pointer ) continue;
+				pointer->setClient( client );
+				setProperty( property.toLatin1().data(), QVariant::fromValue( pointer ) );
+			}
+			if ( type == "Object" ) {
+				pointer->fromJson( pointerData );
+			}
+		} else if ( onlyPointers ) {
+			continue;
+		} else if ( type == "Date" ) {
+			// Parse Date type
+			setProperty( property.toLatin1().data(), QVariant::fromValue( QParseDate(value.toObject()) ) );
+		} else if ( type == "File" ) {
+			// Parse File type; the file is the same while its name and url are the same
+			QJsonObject fileData = value.toObject();
+			QParseFile* file = this->property( property.toLatin1().data() ).value<QParseFile*>();
+			if ( !file || file->getName() != fileData["name"].toString() || file->getUrl() != QUrl(fileData["url"].toString()) ) {
+				QParseFile* previous = file;
+				setProperty( property.toLatin1().data(), QVariant::fromValue( new QParseFile(fileData, this) ) );
+				if ( previous && previous->parent() == this ) {
+					// it may be still referenced by bindings until the event loop runs
+					previous->deleteLater();
+				}
+			}
+		} else {
+			setProperty( property.toLatin1().data(), value.toVariant() );
+		}
+	}
+}
+
 void QParseObject::onUpdateReply( QParseReply* reply ) {
+	if ( !reply->getHasError() ) {
+		QElapsedTimer hydrationTimer;
+		hydrationTimer.start();
+		fromJson( reply->getJson() );
+		getClient()->getStats()->record( "GET classes/"+parseClassName(), "hydration", hydrationTimer.nsecsElapsed()/1000000.0 );
+	}
 	updating = false;
 	emit updatingChanged( updating );
 	emit updatingDone();
@@ -109,7 +229,10 @@ void QParseObject::onUpdateReply( QParseReply* reply ) {
 
 void QParseObject::onSaveReply( QParseReply* reply ) {
 	saving = false;
-	// if id.isEmpty a new object has been created
+	// a new object gets objectId and createdAt, an updated one gets updatedAt
+	if ( !reply->getHasError() ) {
+		fromJson( reply->getJson() );
+	}
 	emit savingChanged( saving );
 	emit savingDone();
 	reply->deleteLater();
@@ -9,6 +9,9 @@
 #include "qparsetypes.h"
 
 class QParseReply;
+class QParse;
+class QParseBatch;
+class QParsePrefetch;
 
 /*! This class contain all common and generic operation than
  *  can be done on all objects stored on PARSE
@@ -36,6 +39,12 @@ class QParseObject : public QObject {
 	 *  \warning Avoid to change any data of the object during save operation
 	 */
 	Q_PROPERTY( bool saving READ isSaving NOTIFY savingChanged )
+	/*! the id given by the outbox to an object not created on PARSE yet (see QParse::offlineWrites)
+	 *  Store it with your copy of the object and set it back after restarting the app,
+	 *  so saving the object again is merged with its creation still in the outbox
+	 *  \note it's not sent to PARSE
+	 */
+	Q_PROPERTY( QString localId READ getLocalId WRITE setLocalId NOTIFY localIdChanged )
 public:
 	/*! constructor of a new object
 	 *  The object will have a empty id, and calling a save with empty id
@@ -59,18 +68,53 @@ public slots:
 	QString getObjectId() const;
 	QParseDate getCreatedAt() const;
 	QParseDate getUpdatedAt() const;
+	QString getLocalId() const;
+	void setLocalId( QString value );
+	//! return the client used for the requests of this object; QParse::instance() by default
+	QParse* getClient() const;
+	//! set the client used for the requests of this object
+	void setClient( QParse* value );
 	//! indicate if there is an updating operation ongoing
 	bool isUpdating();
 	/*! update the data getting them from PARSE
 	 *  \note this does not necessary means it will do a real network request
 	 *        because depending on the QParse caching settings, the data might
 	 *        be retrieved from the network cache
+	 *  \note it does nothing while the outbox has writes of this object not sent yet
 	 */
 	void update();
 	//! indicate if there is an updating operation ongoing
 	bool isSaving();
-	//! save the data to PARSE
+	/*! save the data to PARSE
+	 *  \note with QParse::offlineWrites the object is committed on the outbox,
+	 *        and savingDone is emitted at once
+	 */
 	void save();
+	/*! save all the objects to PARSE using the batch operations
+	 *  The objects are sent in chunks of 50, that is the maximum
+	 *  of PARSE for a batch request, and few chunks are sent in parallel
+	 *  \param client the client used; QParse::instance() when NULL
+	 *  \return the QParseBatch reporting the result of each object;
+	 *          call deleteLater on it when finished
+	 */
+	static QParseBatch* saveAll( QList<QParseObject*> objects, QParse* client=NULL );
+	//! delete all the objects from PARSE using the batch operations (see saveAll)
+	static QParseBatch* deleteAll( QList<QParseObject*> objects, QParse* client=NULL );
+	/*! update all the objects getting their data from PARSE
+	 *  The objects of the same class are fetched with one query
+	 *  on their objectId for each chunk of 50 objects (see saveAll)
+	 */
+	static QParseBatch* fetchAll( QList<QParseObject*> objects, QParse* client=NULL );
+	/*! fetch the objects pointed by the objects, up to depth levels of pointers
+	 *  The pointed objects are fetched with one query for each class and level
+	 *  \return the QParsePrefetch; call deleteLater on it when finished
+	 */
+	static QParsePrefetch* prefetchAll( QList<QParseObject*> objects, int depth=1, QParse* client=NULL );
+	/*! true if the data of the object has been got from PARSE
+	 *  The objects created for the pointers of other objects have only the objectId
+	 *  until they are fetched
+	 */
+	bool isFetched() const;
 	/*! return a JSON object representing the object for PARSE
 	 *  \param onlyChanged if true return a partial representation of the object with
 	 *			only the properties changed since the last saving
@@ -78,6 +122,15 @@ public slots:
 	QJsonObject toJson( bool onlyChanged=false );
 	//! return the JSON pointer-to-object for pointer types on PARSE
 	QJsonObject getJsonPointer();
+	/*! update the object with the Json data from PARSE
+	 *  Only the keys contained into jsonData are changed, so it can be used
+	 *  also with the partial data replied to save operations
+	 *  \note the pointers to other objects are created with only the objectId
+	 *        (see prefetchAll), unless the data of the object is included
+	 *  \param onlyPointers if true only the pointers are set, for the objects already
+	 *         constructed from the same jsonData
+	 */
+	void fromJson( QJsonObject jsonData, bool onlyPointers=false );
 signals:
 	void updatingChanged( bool updating );
 	void updatingDone();
@@ -85,6 +138,7 @@ signals:
 	void savingDone();
 	void createdAtChanged(QParseDate createdAt);
 	void updatedAtChanged(QParseDate updatedAt);
+	void localIdChanged( QString localId );
 private slots:
 	/*! handle the completion of update request */
 	void onUpdateReply( QParseReply* reply );
@@ -96,6 +150,9 @@ private:
 	QParseDate updatedAt;
 	bool updating;
 	bool saving;
+	QString localId;
+	//! the client; NULL means QParse::instance()
+	QParse* client;
 };
 
 #endif // QPARSEOBJECT_H
@@ -0,0 +1,294 @@
+
+#include "qparseoutbox.h"
+#include "qparse.h"
+#include "qparseobject.h"
+#include "qparserequest.h"
+#include "qparsereply.h"
+#include "qparsecacheworker.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QUuid>
+#include <QTimer>
+#include <QFile>
+#include "qparselogging.h"
+
+QParseOutbox::QParseOutbox( QParse* parse, QParseCacheWorker* cacheWorker, QNetworkAccessManager* net, QString filename )
+	: QObject(parse)
+	, parse(parse)
+	, cacheWorker(cacheWorker)
+	, net(net)
+	, filename(filename)
+	, loaded(false)
+	, entries()
+	, objects()
+	, created()
+	, createdOrder() {
+	retryTimer = new QTimer(this);
+	retryTimer->setInterval( 30000 );
+	retryTimer->setSingleShot( true );
+	connect( retryTimer, &QTimer::timeout, this, &QParseOutbox::sendNext );
+	connect( net, &QNetworkAccessManager::networkAccessibleChanged, this, &QParseOutbox::onNetworkAccessibleChanged );
+	if ( !QFile::exists( filename ) ) {
+		// nothing has been stored yet, the outbox is empty
+		loaded = true;
+		return;
+	}
+	// the outbox will be loaded on onLoaded
+	connect( cacheWorker, &QParseCacheWorker::readFinished, this, &QParseOutbox::onLoaded );
+	QMetaObject::invokeMethod( cacheWorker, "read", Qt::QueuedConnection,
+							   Q_ARG(QUrl, QUrl::fromLocalFile(filename)),
+							   Q_ARG(QString, filename),
+							   Q_ARG(QString, QString()) );
+}
+
+int QParseOutbox::getCount() const {
+	return entries.size();
+}
+
+bool QParseOutbox::isPending( QParseObject* object ) const {
+	QString localId = object->getLocalId();
+	QString objectId = object->getObjectId();
+	if ( objectId.isEmpty() ) {
+		objectId = created.value( localId );
+	}
+	foreach( Entry entry, entries ) {
+		if ( !localId.isEmpty() && entry.localId == localId ) return true;
+		// another instance of an object created by the outbox
+		if ( !objectId.isEmpty() && entry.className == object->parseClassName() && entry.objectId == objectId ) return true;
+	}
+	return false;
+}
+
+void QParseOutbox::save( QParseObject* object ) {
+	QString localId = getLocalId( object );
+	int index = findWaiting( localId );
+	if ( index != -1 ) {
+		// merge with the write still waiting; the new values win
+		QJsonObject data = object->toJson();
+		foreach( QString key, data.keys() ) {
+			entries[index].body[key] = data[key];
+		}
+	} else {
+		Entry entry;
+		entry.className = object->parseClassName();
+		entry.objectId = object->getObjectId();
+		entry.localId = localId;
+		entry.body = object->toJson();
+		entry.sent = false;
+		// if the creation has been sent, this is an update of the object not created yet
+		entry.method = ( entry.objectId.isEmpty() && !isPending(object) ) ? "POST" : "PUT";
+		entries.append( entry );
+		emit countChanged( entries.size() );
+	}
+	store();
+	sendNext();
+}
+
+void QParseOutbox::remove( QParseObject* object ) {
+	QString localId = getLocalId( object );
+	// the writes not sent yet are useless
+	bool onParse = !object->getObjectId().isEmpty();
+	for( int i=entries.size()-1; i>=0; i-- ) {
+		if ( entries[i].localId != localId ) continue;
+		if ( entries[i].sent ) {
+			onParse = true;
+		} else {
+			entries.removeAt( i );
+		}
+	}
+	// when the object has never been sent to PARSE, there is nothing to delete
+	if ( onParse ) {
+		Entry entry;
+		entry.method = "DELETE";
+		entry.className = object->parseClassName();
+		entry.objectId = object->getObjectId();
+		entry.localId = localId;
+		entry.sent = false;
+		entries.append( entry );
+	}
+	emit countChanged( entries.size() );
+	store();
+	sendNext();
+}
+
+void QParseOutbox::sendNext() {
+	if ( !loaded || entries.isEmpty() || entries.first().sent ) return;
+	if ( net->networkAccessible() == QNetworkAccessManager::NotAccessible ) return;
+	Entry& entry = entries.first();
+	if ( entry.objectId.isEmpty() && entry.method != "POST" ) {
+		// the creation of the object failed, so the object does not exist on PARSE
+		emit writeFailed( entry.className, entry.objectId, 101, "object not created" );
+		entries.removeFirst();
+		emit countChanged( entries.size() );
+		store();
+		sendNext();
+		return;
+	}
+	entry.sent = true;
+	QParseRequest* request = new QParseRequest( entry.className, parse );
+	request->setObjectId( entry.objectId );
+	request->setBody( entry.body );
+	QParseReply* reply;
+	if ( entry.method == "POST" ) {
+		reply = parse->post( request );
+	} else if ( entry.method == "PUT" ) {
+		reply = parse->put( request );
+	} else {
+		reply = parse->deleteResource( request );
+	}
+	connect( reply, &QParseReply::finished, this, &QParseOutbox::onWriteReply );
+}
+
+void QParseOutbox::onLoaded( QUrl key, QByteArray data, bool ok ) {
+	if ( key != QUrl::fromLocalFile(filename) ) return;
+	disconnect( cacheWorker, &QParseCacheWorker::readFinished, this, &QParseOutbox::onLoaded );
+	// the writes done before loading follow the stored ones
+	QList<Entry> stored;
+	if ( ok ) {
+		foreach( QJsonValue value, QJsonDocument::fromJson( data ).object()["entries"].toArray() ) {
+			QJsonObject entryData = value.toObject();
+			Entry entry;
+			entry.method = entryData["method"].toString();
+			entry.className = entryData["className"].toString();
+			entry.objectId = entryData["objectId"].toString();
+			entry.localId = entryData["localId"].toString();
+			entry.body = entryData["body"].toObject();
+			entry.sent = false;
+			stored << entry;
+		}
+		foreach( QJsonValue value, QJsonDocument::fromJson( data ).object()["created"].toArray() ) {
+			QJsonObject createdData = value.toObject();
+			addCreated( createdData["localId"].toString(), createdData["objectId"].toString() );
+		}
+	}
+	entries = stored + entries;
+	loaded = true;
+	qparseDebug( qparseCache ) << "outbox loaded" << stored.size() << "writes";
+	if ( !stored.isEmpty() ) {
+		emit countChanged( entries.size() );
+		store();
+	}
+	sendNext();
+}
+
+void QParseOutbox::onNetworkAccessibleChanged( QNetworkAccessManager::NetworkAccessibility accessible ) {
+	if ( accessible == QNetworkAccessManager::Accessible ) {
+		retryTimer->stop();
+		sendNext();
+	}
+}
+
+void QParseOutbox::onWriteReply( QParseReply* reply ) {
+	reply->deleteLater();
+	Entry entry = entries.first();
+	int status = reply->getHttpStatus();
+	// only the writes refused by PARSE (4xx, except the request limit) are dropped
+	bool refused = status >= 400 && status < 500 && status != 429 && reply->getErrorCode() != 155;
+	if ( reply->getHasError() && !refused ) {
+		// PARSE not reached, over the request limit or failing on its side (5xx),
+		// or the request cancelled; the write is sent again later
+		qparseDebug( qparseCache ) << "outbox write not done, retry later" << status << reply->getErrorMessage();
+		entries.first().sent = false;
+		retryTimer->start();
+		return;
+	}
+	entries.removeFirst();
+	if ( reply->getHasError() ) {
+		qparseWarning( qparseCache ) << "outbox write refused" << entry.method << entry.className << entry.objectId << reply->getErrorMessage();
+		emit writeFailed( entry.className, entry.objectId, reply->getErrorCode(), reply->getErrorMessage() );
+	} else {
+		QJsonObject data = reply->getJson();
+		QParseObject* object = objects.value( entry.localId );
+		if ( entry.method == "POST" ) {
+			if ( !object ) {
+				// remembered, also after restarting the app, for the object saved again with its localId
+				addCreated( entry.localId, data["objectId"].toString() );
+			}
+			// the following writes of the same object can be sent now
+			for( int i=0; i<entries.size(); i++ ) {
+				if ( entries[i].localId == entry.localId ) {
+					entries[i].objectId = data["objectId"].toString();
+				}
+			}
+		}
+		if ( object && entry.method != "DELETE" ) {
+			object->fromJson( data );
+		}
+	}
+	emit countChanged( entries.size() );
+	store();
+	sendNext();
+}
+
+QString QParseOutbox::getLocalId( QParseObject* object ) {
+	QString localId = object->getLocalId();
+	if ( !localId.isEmpty() ) {
+		// the id is stored with the object by the app, so it's the same after restarting the app
+		if ( object->getObjectId().isEmpty() && created.contains(localId) ) {
+			// created by the outbox while the object was not around
+			QJsonObject data;
+			data["objectId"] = created[localId];
+			object->fromJson( data );
+			// the object has its objectId from now on
+			created.remove( localId );
+			createdOrder.removeOne( localId );
+		}
+	} else if ( !object->getObjectId().isEmpty() ) {
+		// the objects already on PARSE have always the same id, also after restarting the app
+		localId = object->parseClassName()+"/"+object->getObjectId();
+	} else {
+		localId = QUuid::createUuid().toString();
+		object->setLocalId( localId );
+	}
+	objects[localId] = object;
+	return localId;
+}
+
+void QParseOutbox::addCreated( QString localId, QString objectId ) {
+	if ( localId.isEmpty() || created.contains(localId) ) return;
+	created[localId] = objectId;
+	createdOrder.append( localId );
+	// the oldest objects not picked up so far are not likely to be saved again
+	while( createdOrder.size() > maxCreated ) {
+		created.remove( createdOrder.takeFirst() );
+	}
+}
+
+int QParseOutbox::findWaiting( QString localId ) const {
+	for( int i=entries.size()-1; i>=0; i-- ) {
+		if ( entries[i].localId != localId ) continue;
+		if ( entries[i].sent || entries[i].method == "DELETE" ) return -1;
+		return i;
+	}
+	return -1;
+}
+
+void QParseOutbox::store() {
+	QJsonArray entriesData;
+	foreach( Entry entry, entries ) {
+		QJsonObject entryData;
+		entryData["method"] = entry.method;
+		entryData["className"] = entry.className;
+		entryData["objectId"] = entry.objectId;
+		entryData["localId"] = entry.localId;
+		entryData["body"] = entry.body;
+		entriesData.append( entryData );
+	}
+	QJsonArray createdData;
+	foreach( QString localId, createdOrder ) {
+		QJsonObject createdEntry;
+		createdEntry["localId"] = localId;
+		createdEntry["objectId"] = created[localId];
+		createdData.append( createdEntry );
+	}
+	QJsonObject data;
+	data["entries"] = entriesData;
+	data["created"] = createdData;
+	// not coalesced: the outbox has to be on disk as soon as possible
+	QMetaObject::invokeMethod( cacheWorker, "write", Qt::QueuedConnection,
+							   Q_ARG(QUrl, QUrl::fromLocalFile(filename)),
+							   Q_ARG(QString, filename),
+							   Q_ARG(QByteArray, QJsonDocument(data).toJson(QJsonDocument::Compact)),
+							   Q_ARG(QString, QString()),
+							   Q_ARG(bool, false) );
+}
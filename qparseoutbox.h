@@ -0,0 +1,109 @@
+#ifndef QPARSEOUTBOX_H
+#define QPARSEOUTBOX_H
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QStringList>
+#include <QPointer>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+
+class QParse;
+class QParseObject;
+class QParseReply;
+class QParseCacheWorker;
+class QTimer;
+
+/*! The queue of the writes to PARSE stored on disk
+ *
+ *  When QParse::offlineWrites is enabled, QParseObject::save commits the object
+ *  into the outbox and returns at once; the outbox sends the writes to PARSE
+ *  in the same order, one at time, as soon as the network is accessible
+ *
+ *  Successive saves of the same object are merged into one write while it's
+ *  still waiting, and a delete drops the writes waiting for the same object;
+ *  the outbox is written on disk on every change, so the writes survive
+ *  to the app being killed
+ *
+ *  When the write of a new object is done, the objectId is set on the object
+ *  (if it still exists) and on the writes waiting for the same object
+ *
+ *  A new object is identified by its QParseObject::localId; when the app stores
+ *  the localId with the object, saving the object after restarting the app is merged
+ *  with the creation still in the outbox, or gets the objectId of the created one
+ *
+ *  \warning Never create by yourself, it's created by QParse; use it from the thread of QParse
+ */
+class QParseOutbox : public QObject {
+	Q_OBJECT
+	//! the number of writes not sent to PARSE yet
+	Q_PROPERTY( int count READ getCount NOTIFY countChanged )
+public:
+	QParseOutbox( QParse* parse, QParseCacheWorker* cacheWorker, QNetworkAccessManager* net, QString filename );
+public slots:
+	int getCount() const;
+	//! true if there are writes of the object not sent to PARSE yet
+	bool isPending( QParseObject* object ) const;
+	//! add the saving of the object to the outbox
+	void save( QParseObject* object );
+	//! add the deletion of the object to the outbox
+	void remove( QParseObject* object );
+	//! send the next write, if the network is accessible
+	void sendNext();
+signals:
+	void countChanged( int count );
+	/*! emitted when PARSE refused a write (a 4xx reply other than the request limit);
+	 *  the write is dropped from the outbox, all the other errors are retried later
+	 */
+	void writeFailed( QString className, QString objectId, int code, QString message );
+private slots:
+	void onLoaded( QUrl key, QByteArray data, bool ok );
+	void onNetworkAccessibleChanged( QNetworkAccessManager::NetworkAccessibility accessible );
+	void onWriteReply( QParseReply* reply );
+private:
+	//! a write waiting to be sent to PARSE
+	struct Entry {
+		//! POST, PUT or DELETE
+		QString method;
+		QString className;
+		//! empty when the object has not been created on PARSE yet
+		QString objectId;
+		//! identify the object until it has the objectId
+		QString localId;
+		QJsonObject body;
+		//! true while waiting for the reply of PARSE; it cannot be merged anymore
+		bool sent;
+	};
+	//! return the local id of the object, creating one if it has not
+	QString getLocalId( QParseObject* object );
+	//! remember the objectId of a created object, dropping the oldest ones over maxCreated
+	void addCreated( QString localId, QString objectId );
+	//! return the index of the waiting entry of the object, or -1 if there is none
+	int findWaiting( QString localId ) const;
+	//! write down the outbox on disk
+	void store();
+
+	QParse* parse;
+	QParseCacheWorker* cacheWorker;
+	QNetworkAccessManager* net;
+	//! the file on which the outbox is stored
+	QString filename;
+	//! true when the outbox has been loaded from disk
+	bool loaded;
+	QList<Entry> entries;
+	//! the objects of the entries, by their local id
+	QHash< QString, QPointer<QParseObject> > objects;
+	/*! the objectId of the objects created by the outbox while they were not around, by their
+	 *  local id; stored on disk, and dropped when the object gets it (see getLocalId)
+	 */
+	QHash<QString, QString> created;
+	//! the local ids of created, from the oldest
+	QStringList createdOrder;
+	//! the maximum number of objects kept into created
+	static const int maxCreated = 1000;
+	//! retry the sending after a network error
+	QTimer* retryTimer;
+};
+
+#endif // QPARSEOUTBOX_H
@@ -0,0 +1,131 @@
+
+#include "qparsepack.h"
+#include <QFile>
+#include <QBuffer>
+#include <QDataStream>
+#include "qparselogging.h"
+
+//! "QPPK"
+static const quint32 packMagic = 0x5150504B;
+static const quint32 packVersion = 1;
+
+QParsePack::QParsePack()
+	: file(NULL)
+	, mapped(NULL)
+	, index()
+	, urls() {
+}
+
+QParsePack::~QParsePack() {
+	// unmapping is done by QFile on close
+	delete file;
+}
+
+bool QParsePack::open( QString filename ) {
+	delete file;
+	mapped = NULL;
+	index.clear();
+	urls.clear();
+	file = new QFile( filename );
+	if ( !file->open( QIODevice::ReadOnly ) ) {
+		delete file;
+		file = NULL;
+		return false;
+	}
+	QDataStream stream( file );
+	stream.setVersion( QDataStream::Qt_5_0 );
+	quint32 magic, version, count;
+	stream >> magic >> version >> count;
+	if ( magic != packMagic || version != packVersion ) {
+		qparseWarning( qparseCache ) << "not a valid pack" << filename;
+		delete file;
+		file = NULL;
+		return false;
+	}
+	for( quint32 i=0; i<count; i++ ) {
+		Entry entry;
+		stream >> entry.url >> entry.isJson >> entry.codec >> entry.createdAt
+			   >> entry.hash >> entry.suffix >> entry.offset >> entry.size;
+		if ( stream.status() != QDataStream::Ok || entry.offset+entry.size > quint64(file->size()) ) {
+			qparseWarning( qparseCache ) << "corrupted index of pack" << filename;
+			delete file;
+			file = NULL;
+			index.clear();
+			urls.clear();
+			return false;
+		}
+		index[entry.url] = entry;
+		urls << entry.url;
+	}
+	// when the file can be mapped, the data will be read without any copy from the disk
+	mapped = file->map( 0, file->size() );
+	return true;
+}
+
+bool QParsePack::isOpen() const {
+	return file != NULL;
+}
+
+QString QParsePack::getFilename() const {
+	return file ? file->fileName() : QString();
+}
+
+QList<QParsePack::Entry> QParsePack::getEntries() const {
+	QList<Entry> entries;
+	foreach( QUrl url, urls ) {
+		entries << index[url];
+	}
+	return entries;
+}
+
+bool QParsePack::contains( QUrl url ) const {
+	return index.contains( url );
+}
+
+QParsePack::Entry QParsePack::getEntry( QUrl url ) const {
+	return index.value( url );
+}
+
+QByteArray QParsePack::getData( QUrl url ) const {
+	if ( !file || !index.contains(url) ) return QByteArray();
+	Entry entry = index[url];
+	if ( mapped ) {
+		return QByteArray( reinterpret_cast<const char*>(mapped+entry.offset), int(entry.size) );
+	}
+	if ( !file->seek( entry.offset ) ) return QByteArray();
+	return file->read( entry.size );
+}
+
+bool QParsePack::write( QString filename, QList<Entry> entries ) {
+	// the size of the index does not depend on offsets, so write it once
+	// with fake offsets for knowing where the data will start
+	QByteArray header;
+	for( int pass=0; pass<2; pass++ ) {
+		quint64 offset = header.size();
+		header.clear();
+		QBuffer buffer( &header );
+		buffer.open( QIODevice::WriteOnly );
+		QDataStream stream( &buffer );
+		stream.setVersion( QDataStream::Qt_5_0 );
+		stream << packMagic << packVersion << quint32(entries.size());
+		for( int i=0; i<entries.size(); i++ ) {
+			Entry& entry = entries[i];
+			entry.offset = offset;
+			entry.size = entry.data.size();
+			offset += entry.size;
+			stream << entry.url << entry.isJson << entry.codec << entry.createdAt
+				   << entry.hash << entry.suffix << entry.offset << entry.size;
+		}
+	}
+	QFile packFile( filename );
+	if ( !packFile.open( QIODevice::WriteOnly | QIODevice::Truncate ) ) {
+		qparseWarning( qparseCache ) << "cannot write the pack" << filename;
+		return false;
+	}
+	bool ok = ( packFile.write( header ) == header.size() );
+	foreach( Entry entry, entries ) {
+		ok = ok && ( packFile.write( entry.data ) == entry.data.size() );
+	}
+	packFile.close();
+	return ok;
+}
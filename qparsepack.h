@@ -0,0 +1,98 @@
+#ifndef QPARSEPACK_H
+#define QPARSEPACK_H
+
+#include <QString>
+#include <QUrl>
+#include <QList>
+#include <QHash>
+#include <QByteArray>
+#include <QDateTime>
+
+class QFile;
+
+/*! A pack file contains many cached data of QParse into a single file
+ *  with an index at the beginning. It's used for bundling the cache into the app
+ *  (parsecache/parsecache.pack) and it's read directly by mapping it into memory,
+ *  so there is no copy of the bundled cache on first launch
+ *
+ *  The pack files are generated with the qparsepack tool (see tools/qparsepack)
+ *
+ *  Layout (QDataStream, Qt_5_0):
+ *  - magic (quint32), version (quint32), number of entries (quint32)
+ *  - for each entry: url, isJson, codec, createdAt, hash, suffix, offset, size
+ *  - the data of all entries, at the offset (from the beginning of file) stored into the index
+ */
+class QParsePack {
+public:
+	//! an entry of the pack
+	class Entry {
+	public:
+		Entry()
+			: url()
+			, isJson(true)
+			, codec()
+			, createdAt()
+			, hash()
+			, suffix()
+			, offset(0)
+			, size(0)
+			, data() { }
+		//! the url of the request cached
+		QUrl url;
+		//! true for Json data, false for files
+		bool isJson;
+		//! the codec used for storing the data (see QParse::CacheData)
+		QString codec;
+		//! date of creation
+		QDateTime createdAt;
+		//! the SHA-1 hex of the data, as used for the name of files into the cache directory
+		QString hash;
+		//! the extension of the file, if any
+		QString suffix;
+		//! where the data starts into the pack
+		quint64 offset;
+		//! the size of the data into the pack
+		quint64 size;
+		//! the data; used only when writing a pack
+		QByteArray data;
+	};
+
+	QParsePack();
+	~QParsePack();
+	/*! open the pack and load its index
+	 *  \return false if the file does not exist or it's not a valid pack
+	 */
+	bool open( QString filename );
+	//! return true if a valid pack has been opened
+	bool isOpen() const;
+	//! return the filename of the pack
+	QString getFilename() const;
+	//! return the index of the pack
+	QList<Entry> getEntries() const;
+	//! return true if the url is into the pack
+	bool contains( QUrl url ) const;
+	//! return the entry corresponding to the url
+	Entry getEntry( QUrl url ) const;
+	//! return the data stored (not decoded) of the url; empty if not present
+	QByteArray getData( QUrl url ) const;
+
+	/*! write a new pack containing the entries passed
+	 *  \note offset and size of the entries are calculated from their data
+	 */
+	static bool write( QString filename, QList<Entry> entries );
+private:
+	Q_DISABLE_COPY( QParsePack )
+
+	//! the pack file
+	QFile* file;
+	/*! the memory where the file has been mapped
+	 *  If mapping is not possible (i.e. Android assets) it's NULL and the data is read
+	 */
+	uchar* mapped;
+	//! the index of the pack
+	QHash<QUrl, Entry> index;
+	//! the order of entries into the index
+	QList<QUrl> urls;
+};
+
+#endif // QPARSEPACK_H
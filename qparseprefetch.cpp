@@ -0,0 +1,75 @@
+
+#include "qparseprefetch.h"
+#include "qparse.h"
+#include "qparseobject.h"
+#include "qparsebatch.h"
+#include "qparselogging.h"
+
+QParsePrefetch::QParsePrefetch( QList<QParseObject*> objects, int depth, QParse* client )
+	: QObject(QParse::parentForCurrentThread(client))
+	, objects(objects)
+	, depth(depth)
+	, client(client ? client : QParse::instance())
+	, level(objects)
+	, levelsDone(0)
+	, visited()
+	, error(false) {
+	// gives the time to connect to finished signal
+	QMetaObject::invokeMethod( this, "fetchLevel", Qt::QueuedConnection );
+}
+
+QList<QParseObject*> QParsePrefetch::getUnresolvedPointers( QParseObject* object ) {
+	QList<QParseObject*> pointers;
+	foreach( QString property, object->parseProperties() ) {
+		QVariant value = object->property( property.toLatin1().data() );
+		if ( !value.canConvert<QParseObject*>() ) continue;
+		QParseObject* pointer = value.value<QParseObject*>();
+		if ( pointer && !pointer->getObjectId().isEmpty() && !pointer->isFetched() ) {
+			pointers << pointer;
+		}
+	}
+	return pointers;
+}
+
+QList<QParseObject*> QParsePrefetch::getObjects() const {
+	return objects;
+}
+
+int QParsePrefetch::getDepth() const {
+	return depth;
+}
+
+bool QParsePrefetch::hasError() const {
+	return error;
+}
+
+void QParsePrefetch::fetchLevel() {
+	QList<QParseObject*> pointers;
+	if ( levelsDone < depth ) {
+		foreach( QParseObject* object, level ) {
+			foreach( QParseObject* pointer, getUnresolvedPointers( object ) ) {
+				if ( visited.contains(pointer) ) continue;
+				visited.insert( pointer );
+				pointers << pointer;
+			}
+		}
+	}
+	if ( pointers.isEmpty() ) {
+		emit finished( this );
+		return;
+	}
+	// the same object pointed many times is fetched with only one query
+	QParseBatch* batch = new QParseBatch( QParseBatch::Fetch, pointers, client );
+	connect( batch, &QParseBatch::finished, this, &QParsePrefetch::onLevelFetched );
+}
+
+void QParsePrefetch::onLevelFetched( QParseBatch* batch ) {
+	if ( batch->hasError() ) {
+		qparseDebug( qparseQuery ) << "prefetch cannot fetch" << batch->getFailed().size() << "pointed objects";
+		error = true;
+	}
+	level = batch->getSucceeded();
+	levelsDone++;
+	batch->deleteLater();
+	fetchLevel();
+}
@@ -0,0 +1,64 @@
+#ifndef QPARSEPREFETCH_H
+#define QPARSEPREFETCH_H
+
+#include <QObject>
+#include <QList>
+#include <QSet>
+
+class QParse;
+class QParseObject;
+class QParseBatch;
+
+/*! It resolves the pointers of a set of objects
+ *
+ *  The pointers to other objects are created by QParseObject::fromJson with only
+ *  their objectId; the prefetch collects the unresolved ones, and fetches all of
+ *  them with one query for each class (see QParseObject::fetchAll) instead of
+ *  calling update on each one
+ *
+ *  The data fetched is set on the objects pointed by the properties, so the
+ *  objects returned by a query get the data of the objects they point to;
+ *  with a depth bigger than one, the pointers of the fetched objects are
+ *  resolved too, up to depth levels
+ *
+ *  Create it with QParseObject::prefetchAll or using QParseQuery::setPrefetchDepth
+ */
+class QParsePrefetch : public QObject {
+	Q_OBJECT
+public:
+	/*! constructor
+	 *  The prefetch starts as soon as the control returns to the event loop,
+	 *  so connect to the finished signal just after the creation
+	 *  \param depth how many levels of pointers are resolved
+	 *  \param client the client used; QParse::instance() when NULL
+	 */
+	QParsePrefetch( QList<QParseObject*> objects, int depth=1, QParse* client=NULL );
+	//! return the pointers to objects of PARSE not fetched yet of the object
+	static QList<QParseObject*> getUnresolvedPointers( QParseObject* object );
+public slots:
+	//! return the objects which pointers are resolved
+	QList<QParseObject*> getObjects() const;
+	int getDepth() const;
+	//! true if some pointed objects cannot be fetched
+	bool hasError() const;
+signals:
+	//! emitted when all the levels have been resolved
+	void finished( QParsePrefetch* prefetch );
+private slots:
+	//! fetch the unresolved pointers of the current level
+	void fetchLevel();
+	void onLevelFetched( QParseBatch* batch );
+private:
+	QList<QParseObject*> objects;
+	int depth;
+	QParse* client;
+	//! the objects of the current level
+	QList<QParseObject*> level;
+	//! the number of levels fetched so far
+	int levelsDone;
+	//! the objects already fetched, for avoiding to fetch twice on cyclic references
+	QSet<QParseObject*> visited;
+	bool error;
+};
+
+#endif // QPARSEPREFETCH_H
@@ -1,17 +1,22 @@
 #include "qparsequery.h"
 #include "qparserequest.h"
 #include "qparsereply.h"
+#include "qparseprefetch.h"
+#include "qparsestats.h"
+#include "qparsetrace.h"
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QJsonDocument>
-#include <QDebug>
+#include <QElapsedTimer>
 
-QParseQuery::QParseQuery( QString parseClassName, QMetaObject metaParseObject )
-	: QObject(QParse::instance())
+QParseQuery::QParseQuery( QString parseClassName, QMetaObject metaParseObject, QParse* client )
+	: QObject(QParse::parentForCurrentThread(client))
 	, cacheControl(QParse::AlwaysCache)
+	, prefetchDepth(0)
 	, metaParseObject(metaParseObject)
-	, parseClassName(parseClassName) {
-	queryRequest = new QParseRequest(parseClassName);
+	, parseClassName(parseClassName)
+	, client(client) {
+	queryRequest = new QParseRequest(parseClassName, client);
 }
 
 QParseQuery* QParseQuery::whereIn(QString property, QStringList values) {
@@ -35,7 +40,8 @@ void QParseQuery::query() {
 	if ( !where.isEmpty() ) {
 		queryRequest->addOption( "where", QJsonDocument(where).toJson(QJsonDocument::Compact) );
 	}
-	QParseReply* reply = QParse::instance()->get( queryRequest );
+	QParseReply* reply = client->get( queryRequest );
+	reply->setOwner( this );
 	connect( reply, &QParseReply::finished, this, &QParseQuery::onQueryReply );
 }
 
@@ -45,17 +51,46 @@ void QParseQuery::onQueryReply( QParseReply* reply ) {
 		return;
 	}
 	// elaborate the result and create objects
-	QParse* parse = QParse::instance();
-	QJsonArray results = reply->getJson()["results"].toArray();
+	QObject* parse = QParse::parentForCurrentThread( client );
 	QList<QParseObject*> parseObjects;
-	for( int i=0; i<results.count(); i++ ) {
-		QJsonObject object = results.at(i).toObject();
-		// call the constructor passing the json object data
-		QParseObject* parseObject = qobject_cast<QParseObject*>(metaParseObject.newInstance( Q_ARG(QJsonObject, object), Q_ARG(QObject*, parse) ));
-		parseObjects << parseObject;
+	{
+		QParseTraceScope trace( "hydration" );
+		QElapsedTimer hydrationTimer;
+		hydrationTimer.start();
+		QJsonArray results = reply->getJson()["results"].toArray();
+		for( int i=0; i<results.count(); i++ ) {
+			QJsonObject object = results.at(i).toObject();
+			// call the constructor passing the json object data
+			QParseObject* parseObject = qobject_cast<QParseObject*>(metaParseObject.newInstance( Q_ARG(QJsonObject, object), Q_ARG(QObject*, parse) ));
+			parseObject->setClient( client );
+			if ( prefetchDepth > 0 ) {
+				// the constructor sets the properties, but only fromJson creates the pointers to prefetch
+				parseObject->fromJson( object, true );
+			}
+			parseObjects << parseObject;
+		}
+		client->getStats()->record( "GET classes/"+parseClassName, "hydration", hydrationTimer.nsecsElapsed()/1000000.0 );
 	}
-	emit queryResults( parseObjects );
 	reply->deleteLater();
+	if ( prefetchDepth > 0 ) {
+		QParsePrefetch* prefetch = new QParsePrefetch( parseObjects, prefetchDepth, client );
+		connect( prefetch, &QParsePrefetch::finished, this, &QParseQuery::onPrefetchFinished );
+		return;
+	}
+	emit queryResults( parseObjects );
+}
+
+void QParseQuery::onPrefetchFinished( QParsePrefetch* prefetch ) {
+	emit queryResults( prefetch->getObjects() );
+	prefetch->deleteLater();
+}
+
+int QParseQuery::getPrefetchDepth() const {
+	return prefetchDepth;
+}
+
+void QParseQuery::setPrefetchDepth( int value ) {
+	prefetchDepth = value;
 }
 
 QParse::CacheControl QParseQuery::getCacheControl() const {
@@ -6,6 +6,8 @@
 #include "qparseobject.h"
 #include "qparsetypes.h"
 
+class QParsePrefetch;
+
 /*! Instanced an object of this class for perform a query on PARSE
  *  and retrieving a collection of PARSE objects
  */
@@ -13,15 +15,19 @@ class QParseQuery : public QObject {
 	Q_OBJECT
 	//! the cache control
 	Q_PROPERTY( QParse::CacheControl cacheControl MEMBER cacheControl )
+	//! the levels of pointers of the results fetched before emitting them
+	Q_PROPERTY( int prefetchDepth READ getPrefetchDepth WRITE setPrefetchDepth )
 public:
-	/*! constructor a new query */
+	/*! constructor a new query
+	 *  \param client the client to use for the query; NULL means QParse::instance()
+	 */
 	template<class ParseObject>
-	static QParseQuery* create( QString className=QString() ) {
+	static QParseQuery* create( QString className=QString(), QParse* client=NULL ) {
 		if ( className.isEmpty() ) {
 			ParseObject p;
 			className = p.parseClassName();
 		}
-		return new QParseQuery(className, ParseObject::staticMetaObject);
+		return new QParseQuery(className, ParseObject::staticMetaObject, client ? client : QParse::instance());
 	}	
 public slots:
 	//! create a where clause
@@ -33,6 +39,13 @@ public slots:
 
 	QParse::CacheControl getCacheControl() const;
 	void setCacheControl(const QParse::CacheControl &value);
+
+	int getPrefetchDepth() const;
+	/*! set how many levels of pointers are fetched before emitting the results
+	 *  The objects pointed by the results are fetched with one query for each class
+	 *  and level (see QParsePrefetch); 0, the default, means no prefetch
+	 */
+	void setPrefetchDepth( int value );
 signals:
 	//! return the all retrieved objects
 	void queryResults( QList<QParseObject*> results );
@@ -42,13 +55,17 @@ protected:
 private slots:
 	/*! handle the completion of get request on PARSE */
 	void onQueryReply( QParseReply* reply );
+	/*! emit the results when their pointers have been fetched */
+	void onPrefetchFinished( QParsePrefetch* prefetch );
 private:
 	// disable public constructors
-	QParseQuery( QString parseClassName, QMetaObject metaParseObject );
+	QParseQuery( QString parseClassName, QMetaObject metaParseObject, QParse* client );
 	Q_DISABLE_COPY( QParseQuery )
 
 	//! the cache control to use
 	QParse::CacheControl cacheControl;
+	//! the levels of pointers to fetch
+	int prefetchDepth;
 
 	//! the underlying QParseRequest to use
 	QParseRequest* queryRequest;
@@ -60,6 +77,8 @@ private:
 	QMetaObject metaParseObject;
 	//! the Parse class name target of the query
 	QString parseClassName;
+	//! the client used for the query and for the objects retrieved
+	QParse* client;
 };
 
 #endif // QPARSEQUERY_H
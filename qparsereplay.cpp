@@ -0,0 +1,274 @@
+
+#include "qparsereplay.h"
+#include "qparsecapture.h"
+#include "qparserequest.h"
+#include "qparsereply.h"
+#include "qparselogging.h"
+#include "qparsememorytransport.h"
+#include <QFile>
+#include <QTimer>
+#include <QUrlQuery>
+#include <QStringList>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <algorithm>
+
+QParseReplay::QParseReplay( QObject* parent )
+	: QObject(parent)
+	, baseUrl()
+	, exchanges()
+	, replies()
+	, mutex()
+	, factory(this)
+	, speed(1)
+	, cacheControl(QParse::AlwaysNetwork)
+	, client(NULL)
+	, running(false)
+	, remaining(0)
+	, replayed(0)
+	, failed(0)
+	, elapsed(0) {
+}
+
+QParseReplay::~QParseReplay() {
+}
+
+bool QParseReplay::load( QString filename ) {
+	QFile file( filename );
+	if ( !file.open( QIODevice::ReadOnly ) ) {
+		qparseWarning( qparseNetwork ) << "cannot read the capture" << filename;
+		return false;
+	}
+	QJsonObject header = QJsonDocument::fromJson( file.readLine() ).object();
+	if ( header["qparseCapture"].toInt() != 1 ) {
+		qparseWarning( qparseNetwork ) << "not a capture of QParse" << filename;
+		return false;
+	}
+	QMutexLocker locker( &mutex );
+	baseUrl = QUrl( header["baseUrl"].toString() );
+	exchanges.clear();
+	replies.clear();
+	while( !file.atEnd() ) {
+		QJsonObject entry = QJsonDocument::fromJson( file.readLine() ).object();
+		if ( entry.isEmpty() ) continue;
+		Exchange exchange;
+		exchange.t = qint64( entry["t"].toDouble() );
+		exchange.method = entry["method"].toString().toLatin1();
+		exchange.url = QUrl( entry["url"].toString() );
+		exchange.requestBody = entry["requestBody"].toString().toUtf8();
+		exchange.status = entry["status"].toInt();
+		exchange.error = entry["error"].toInt();
+		QJsonObject headers = entry["responseHeaders"].toObject();
+		foreach( QString name, headers.keys() ) {
+			exchange.responseHeaders << qMakePair( name.toLatin1(), headers[name].toString().toLatin1() );
+		}
+		if ( entry["responseEncoding"].toString() == "base64" ) {
+			exchange.responseBody = QByteArray::fromBase64( entry["responseBody"].toString().toLatin1() );
+		} else {
+			exchange.responseBody = entry["responseBody"].toString().toUtf8();
+		}
+		exchange.ttfb = entry["ttfb"].toDouble();
+		exchange.duration = qint64( entry["duration"].toDouble() );
+		replies[exchangeKey(exchange.method, exchange.url)] << exchanges.size();
+		exchanges << exchange;
+	}
+	return true;
+}
+
+QUrl QParseReplay::getBaseUrl() const {
+	QMutexLocker locker( &mutex );
+	return baseUrl;
+}
+
+int QParseReplay::getCount() const {
+	QMutexLocker locker( &mutex );
+	return exchanges.size();
+}
+
+QQmlNetworkAccessManagerFactory* QParseReplay::getNetworkAccessManagerFactory() {
+	return &factory;
+}
+
+bool QParseReplay::takeReply( QByteArray method, QUrl url, Exchange* exchange ) {
+	QMutexLocker locker( &mutex );
+	QString key = exchangeKey( method, url );
+	if ( !replies.contains(key) || replies[key].isEmpty() ) return false;
+	QList<int>& indexes = replies[key];
+	// the last one is used again when the request is sent more times than recorded
+	*exchange = exchanges[ indexes.size() > 1 ? indexes.takeFirst() : indexes.first() ];
+	return true;
+}
+
+double QParseReplay::getSpeed() const {
+	QMutexLocker locker( &mutex );
+	return speed;
+}
+
+void QParseReplay::setSpeed( double value ) {
+	QMutexLocker locker( &mutex );
+	if ( speed == value ) return;
+	speed = qMax( 0.0, value );
+	locker.unlock();
+	emit speedChanged( value );
+}
+
+QParse::CacheControl QParseReplay::getCacheControl() const {
+	return cacheControl;
+}
+
+void QParseReplay::setCacheControl( QParse::CacheControl value ) {
+	if ( cacheControl == value ) return;
+	cacheControl = value;
+	emit cacheControlChanged( value );
+}
+
+void QParseReplay::start( QParse* client ) {
+	if ( running ) return;
+	this->client = client;
+	client->setBaseUrl( getBaseUrl() );
+	running = true;
+	remaining = exchanges.size();
+	replayed = 0;
+	failed = 0;
+	elapsed = 0;
+	timer.start();
+	double pace = getSpeed();
+	for( int i=0; i<exchanges.size(); i++ ) {
+		qint64 delay = pace > 0 ? qint64( exchanges[i].t/pace ) : 0;
+		QTimer::singleShot( int(delay), this, [this, i]() {
+			submit( i );
+		});
+	}
+	if ( remaining == 0 ) {
+		done();
+	}
+}
+
+bool QParseReplay::isRunning() const {
+	return running;
+}
+
+qint64 QParseReplay::getElapsed() const {
+	return running ? timer.elapsed() : elapsed;
+}
+
+int QParseReplay::getReplayed() const {
+	return replayed;
+}
+
+int QParseReplay::getFailed() const {
+	return failed;
+}
+
+void QParseReplay::onReplyFinished( QParseReply* reply ) {
+	if ( reply->getHasError() ) {
+		failed++;
+	}
+	reply->deleteLater();
+	done();
+}
+
+void QParseReplay::submit( int index ) {
+	const Exchange& exchange = exchanges[index];
+	// the path relative to the base url: classes/<class>/<objectId>, users/<objectId>, login, batch
+	QString basePath = client->getEndpoint("").path();
+	QString path = exchange.url.path();
+	if ( !path.startsWith(basePath) ) {
+		// files are on another host
+		done();
+		return;
+	}
+	QStringList segments = path.mid( basePath.size() ).split( "/" );
+	QString className;
+	QString objectId;
+	if ( segments[0] == "classes" && segments.size() >= 2 ) {
+		className = segments[1];
+		objectId = segments.value(2);
+	} else if ( segments[0] == "users" ) {
+		className = "_Users";
+		objectId = segments.value(1);
+	} else if ( segments[0] == "login" || segments[0] == "batch" ) {
+		className = segments[0];
+	} else {
+		// installations and config are sent directly by QParse
+		done();
+		return;
+	}
+	QParseRequest* request = new QParseRequest( className, client );
+	request->setObjectId( objectId );
+	request->setCacheControl( cacheControl );
+	QList< QPair<QString, QString> > options = QUrlQuery(exchange.url).queryItems( QUrl::FullyDecoded );
+	for( int i=0; i<options.size(); i++ ) {
+		request->addOption( options[i].first, options[i].second );
+	}
+	if ( !exchange.requestBody.isEmpty() ) {
+		request->setBody( QJsonDocument::fromJson( exchange.requestBody ).object() );
+	}
+	QParseReply* reply;
+	if ( exchange.method == "POST" ) {
+		reply = client->post( request );
+	} else if ( exchange.method == "PUT" ) {
+		reply = client->put( request );
+	} else if ( exchange.method == "DELETE" ) {
+		reply = client->deleteResource( request );
+	} else {
+		reply = client->get( request );
+	}
+	replayed++;
+	connect( reply, &QParseReply::finished, this, &QParseReplay::onReplyFinished );
+}
+
+void QParseReplay::done() {
+	remaining--;
+	if ( remaining > 0 ) return;
+	elapsed = timer.elapsed();
+	running = false;
+	emit finished();
+}
+
+QString QParseReplay::exchangeKey( QByteArray method, QUrl url ) {
+	// the same request may have the options in another order or encoded differently
+	url = QParseCapture::strip( url );
+	QList< QPair<QString, QString> > items = QUrlQuery(url).queryItems( QUrl::FullyDecoded );
+	std::sort( items.begin(), items.end() );
+	QStringList query;
+	for( int i=0; i<items.size(); i++ ) {
+		query << items[i].first+"="+items[i].second;
+	}
+	return QString::fromLatin1(method)+" "+url.adjusted( QUrl::RemoveQuery ).toString()+"?"+query.join("&");
+}
+
+QNetworkAccessManager* QParseReplay::NetworkFactory::create( QObject* parent ) {
+	return new QParseReplayNetworkAccessManager( replay, parent );
+}
+
+QParseReplayNetworkAccessManager::QParseReplayNetworkAccessManager( QParseReplay* replay, QObject* parent )
+	: QNetworkAccessManager(parent)
+	, replay(replay) {
+}
+
+QNetworkReply* QParseReplayNetworkAccessManager::createRequest( Operation op, const QNetworkRequest& request, QIODevice* outgoingData ) {
+	Q_UNUSED( outgoingData )
+	static const char* methods[] = { "", "HEAD", "GET", "PUT", "POST", "DELETE", "" };
+	QByteArray method = ( op >= HeadOperation && op <= DeleteOperation ) ? methods[op] : "";
+	QParseReplay::Exchange exchange;
+	QParseMemoryTransport::Response response;
+	if ( replay->takeReply( method, request.url(), &exchange ) ) {
+		response.status = exchange.status;
+		response.error = QNetworkReply::NetworkError( exchange.error );
+		response.headers = exchange.responseHeaders;
+		response.body = exchange.responseBody;
+		double speed = replay->getSpeed();
+		response.latency = speed > 0 ? int( qMax(0.0, exchange.ttfb)/speed ) : 0;
+		response.duration = speed > 0 ? int( exchange.duration/speed ) : 0;
+	} else {
+		qparseDebug( qparseNetwork ) << "replay: request not recorded" << method << request.url();
+		// like PARSE when the object does not exist
+		response.status = 404;
+		response.error = QNetworkReply::ContentNotFoundError;
+		response.body = "{\"code\":101,\"error\":\"not recorded\"}";
+		response.latency = 0;
+	}
+	return new QParseMemoryReply( op, request, response, this );
+}
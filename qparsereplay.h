@@ -0,0 +1,151 @@
+#ifndef QPARSEREPLAY_H
+#define QPARSEREPLAY_H
+
+#include <QObject>
+#include <QUrl>
+#include <QList>
+#include <QPair>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QQmlNetworkAccessManagerFactory>
+#include "qparse.h"
+
+class QParseReply;
+
+/*! It replays the requests recorded by QParseCapture (see QParse::captureFile)
+ *
+ *  The recorded requests are submitted again to a QParse client, at the pace of the
+ *  recording or accelerated, and they pass through all its pipeline (dispatchers,
+ *  throttle, cache, parsing); the network is replaced by the recorded replies,
+ *  delivered after the recorded latency. So the timings of QParseStats of two
+ *  versions of QParse can be compared on the same traffic
+ *
+ *  \code
+ *  QParseReplay replay;
+ *  replay.load( "capture.jsonl" );
+ *  QParse::setNetworkAccessManagerFactory( replay.getNetworkAccessManagerFactory() );
+ *  QParse* client = new QParse( "replay" );
+ *  replay.setSpeed( 4 );
+ *  replay.start( client );
+ *  // on finished: client->getStats()->toJson()
+ *  \endcode
+ *
+ *  The requests of installations, config and files are not replayed (they are not
+ *  submitted as QParseRequest), but their recorded replies are still served
+ */
+class QParseReplay : public QObject {
+	Q_OBJECT
+	/*! the speed of the replay: 1 is the pace of the recording, 2 is twice as fast;
+	 *  0 means all the requests are submitted at once and replied without latency
+	 */
+	Q_PROPERTY( double speed READ getSpeed WRITE setSpeed NOTIFY speedChanged )
+	/*! the cache control of the requests replayed; the default AlwaysNetwork sends them
+	 *  all like recorded, AlwaysCache measures the cache on the recorded traffic
+	 */
+	Q_PROPERTY( QParse::CacheControl cacheControl READ getCacheControl WRITE setCacheControl NOTIFY cacheControlChanged )
+public:
+	QParseReplay( QObject* parent=0 );
+	~QParseReplay();
+	//! a recorded request with its reply
+	struct Exchange {
+		Exchange() : t(0), method(), url(), requestBody(), status(0), error(0),
+			responseHeaders(), responseBody(), ttfb(0), duration(0) { }
+		qint64 t;
+		QByteArray method;
+		QUrl url;
+		QByteArray requestBody;
+		int status;
+		int error;
+		QList< QPair<QByteArray, QByteArray> > responseHeaders;
+		QByteArray responseBody;
+		double ttfb;
+		qint64 duration;
+	};
+	/*! load the capture from the file
+	 *  \return false if the file is not a capture of QParseCapture
+	 */
+	bool load( QString filename );
+	//! the base url of the recording; the client is set to it by start
+	QUrl getBaseUrl() const;
+	//! the number of requests recorded
+	int getCount() const;
+	/*! return the factory of the network managers replying with the recorded replies
+	 *  Set it with QParse::setNetworkAccessManagerFactory before creating the client of the replay
+	 */
+	QQmlNetworkAccessManagerFactory* getNetworkAccessManagerFactory();
+	/*! \internal return the recorded reply to the request, in the order of recording
+	 *  when the same request has been recorded many times
+	 *  \return false if the request has not been recorded
+	 */
+	bool takeReply( QByteArray method, QUrl url, Exchange* exchange );
+public slots:
+	double getSpeed() const;
+	void setSpeed( double value );
+	QParse::CacheControl getCacheControl() const;
+	void setCacheControl( QParse::CacheControl value );
+	//! submit the recorded requests to the client; finished is emitted when all are replied
+	void start( QParse* client );
+	bool isRunning() const;
+	//! the milliseconds from the start to the last reply
+	qint64 getElapsed() const;
+	//! the number of requests replayed and the number of them finished with an error
+	int getReplayed() const;
+	int getFailed() const;
+signals:
+	void speedChanged( double speed );
+	void cacheControlChanged( QParse::CacheControl cacheControl );
+	void finished();
+private slots:
+	void onReplyFinished( QParseReply* reply );
+private:
+	Q_DISABLE_COPY( QParseReplay )
+	//! submit the request of the exchange to the client
+	void submit( int index );
+	//! count the end of a request, and emit finished after the last one
+	void done();
+	//! return the key matching the replies to the requests
+	static QString exchangeKey( QByteArray method, QUrl url );
+
+	class NetworkFactory : public QQmlNetworkAccessManagerFactory {
+	public:
+		NetworkFactory( QParseReplay* replay ) : replay(replay) { }
+		virtual QNetworkAccessManager* create( QObject* parent );
+	private:
+		QParseReplay* replay;
+	};
+
+	QUrl baseUrl;
+	QList<Exchange> exchanges;
+	//! the indexes of the exchanges not replied yet by request; the network managers of
+	//! the dispatchers take them from their threads, so they are protected by mutex
+	QHash< QString, QList<int> > replies;
+	mutable QMutex mutex;
+	NetworkFactory factory;
+	double speed;
+	QParse::CacheControl cacheControl;
+	QParse* client;
+	bool running;
+	int remaining;
+	int replayed;
+	int failed;
+	QElapsedTimer timer;
+	qint64 elapsed;
+};
+
+/*! \internal The network manager of the dispatchers during a replay
+ *  It replies to the requests with the replies recorded, without network
+ */
+class QParseReplayNetworkAccessManager : public QNetworkAccessManager {
+	Q_OBJECT
+public:
+	QParseReplayNetworkAccessManager( QParseReplay* replay, QObject* parent=0 );
+protected:
+	virtual QNetworkReply* createRequest( Operation op, const QNetworkRequest& request, QIODevice* outgoingData );
+private:
+	QParseReplay* replay;
+};
+
+#endif // QPARSEREPLAY_H
@@ -9,7 +9,12 @@ QParseReply::QParseReply(QParseRequest *request, QParse *parent)
 	, isJson(true)
 	, hasError(false)
 	, errorMessage()
-	, errorCode(0) {
+	, errorCode(0)
+	, networkError(false)
+	, httpStatus(0)
+	, bytesSaved(0)
+	, client(NULL)
+	, aborted(0) {
 
 }
 
@@ -64,3 +69,64 @@ int QParseReply::getErrorCode() const {
 void QParseReply::setErrorCode(int value) {
 	errorCode = value;
 }
+
+bool QParseReply::getNetworkError() const {
+	return networkError;
+}
+
+void QParseReply::setNetworkError(bool value) {
+	networkError = value;
+}
+
+int QParseReply::getHttpStatus() const {
+	return httpStatus;
+}
+
+void QParseReply::setHttpStatus(int value) {
+	httpStatus = value;
+}
+
+int QParseReply::getBytesSaved() const {
+	return bytesSaved;
+}
+
+void QParseReply::setBytesSaved(int value) {
+	bytesSaved = value;
+}
+
+bool QParseReply::isAborted() const {
+	return aborted.loadAcquire() != 0;
+}
+
+void QParseReply::setOwner( QObject* owner ) {
+	connect( owner, &QObject::destroyed, this, [this]() {
+		// nobody will handle the reply anymore
+		connect( this, &QParseReply::finished, this, &QObject::deleteLater );
+		abort();
+	});
+}
+
+void QParseReply::abort() {
+	QParse* parse = client.loadAcquire();
+	if ( !parse || !aborted.testAndSetOrdered( 0, 1 ) ) return;
+	// the request is removed by its dispatcher on its own thread
+	parse->abortReply( this );
+}
+
+QParseResult::QParseResult()
+	: isJson(true)
+	, json()
+	, localUrl()
+	, hasError(false)
+	, errorMessage()
+	, errorCode(0) {
+}
+
+QParseResult::QParseResult( const QParseReply* reply )
+	: isJson(reply->getIsJson())
+	, json(reply->getJson())
+	, localUrl(reply->getLocalUrl())
+	, hasError(reply->getHasError())
+	, errorMessage(reply->getErrorMessage())
+	, errorCode(reply->getErrorCode()) {
+}
@@ -4,6 +4,8 @@
 #include <QObject>
 #include <QJsonObject>
 #include <QUrl>
+#include <QAtomicInt>
+#include <QAtomicPointer>
 
 class QParseRequest;
 class QParse;
@@ -13,6 +15,9 @@ class QParse;
  *  Bind the signal finished to the proper slot delegate to handle the data returned
  *  by PARSE
  *
+ *  A request can be cancelled with abort(); the finished signal is always emitted,
+ *  with the error QNetworkReply::OperationCanceledError when the request has been cancelled
+ *
  *  \warning Never create by yourself
  */
 class QParseReply : public QObject {
@@ -33,10 +38,19 @@ class QParseReply : public QObject {
 	Q_PROPERTY( QString errorMessage MEMBER errorMessage )
 	//! the error code, if any
 	Q_PROPERTY( int errorCode MEMBER errorCode )
+	/*! if true means that PARSE has not been reached (no connection, timeout, etc)
+	 *  and the request can be sent again later; otherwise the error is from PARSE
+	 */
+	Q_PROPERTY( bool networkError MEMBER networkError )
+	//! the HTTP status code replied by PARSE; 0 when PARSE has not been reached or the reply is from the cache
+	Q_PROPERTY( int httpStatus MEMBER httpStatus )
+	//! the bytes saved by compressing the body of the request (see QParse::requestCompression)
+	Q_PROPERTY( int bytesSaved MEMBER bytesSaved )
 public:
 	/*! Constructor
 	 *  the parent is always QParse singleton instance because
-	 *  this object is created by QParse singleton
+	 *  this object is created by QParse singleton; except when the request
+	 *  is submitted from another thread, in that case there is no parent
 	 */
 	QParseReply( QParseRequest* request, QParse* parent );
 
@@ -60,6 +74,30 @@ public:
 	int getErrorCode() const;
 	void setErrorCode(int value);
 
+	bool getNetworkError() const;
+	void setNetworkError(bool value);
+
+	int getHttpStatus() const;
+	void setHttpStatus(int value);
+
+	int getBytesSaved() const;
+	void setBytesSaved(int value);
+
+	//! true if abort has been called
+	bool isAborted() const;
+	/*! abort the request when the owner is destroyed
+	 *  In that case the reply deletes itself when finished, because nobody will handle it
+	 */
+	void setOwner( QObject* owner );
+public slots:
+	/*! cancel the request
+	 *  If the request is still queued it's removed from the queue, if it has been sent
+	 *  the network request is aborted; it's safe to call it from the thread of the reply
+	 *  also when the request is processed on another thread
+	 *  \warning do not delete the reply until finished is emitted
+	 */
+	void abort();
+
 signals:
 	//! emitted when the reply has been arrived and prepared to be processed
 	void finished( QParseReply* reply);
@@ -78,6 +116,41 @@ private:
 	QString errorMessage;
 	//! the error code, if any
 	int errorCode;
+	//! true means PARSE has not been reached
+	bool networkError;
+	//! the HTTP status code of the reply of PARSE
+	int httpStatus;
+	//! the bytes saved by the compression of the request
+	int bytesSaved;
+	friend class QParse;
+	//! the client processing the request; NULL when finished
+	QAtomicPointer<QParse> client;
+	//! set by abort, it can be read from the thread of the dispatcher
+	QAtomicInt aborted;
+};
+
+/*! A copy of the data of a QParseReply
+ *  It's the result of the QFuture returned by QParse::getAsync, postAsync and putAsync
+ */
+class QParseResult {
+public:
+	//! default constructor; it's an empty result without error
+	QParseResult();
+	//! construct the result from the data of the reply
+	QParseResult( const QParseReply* reply );
+	//! true means the data is a JSON object
+	bool isJson;
+	//! the Json object containing the reply
+	QJsonObject json;
+	//! it point to a local file on cache
+	QUrl localUrl;
+	//! true means there was an error during the request
+	bool hasError;
+	//! the error message, if any
+	QString errorMessage;
+	//! the error code, if any
+	int errorCode;
 };
+Q_DECLARE_METATYPE( QParseResult )
 
 #endif // QPARSEREPLY
@@ -1,23 +1,30 @@
 
 #include "qparse.h"
 #include "qparserequest.h"
+#include "qparseobject.h"
 
-QParseRequest::QParseRequest( QString parseClassName )
-	: QObject(QParse::instance())
+QParseRequest::QParseRequest( QString parseClassName, QParse* client )
+	: QObject(QParse::parentForCurrentThread(client))
 	, parseClassName(parseClassName)
 	, parseObject(NULL)
+	, objectId()
 	, parseFile(NULL)
 	, cacheControl(QParse::AlwaysCache)
-	, params() {
+	, params()
+	, body()
+	, deadline(0) {
 }
 
-QParseRequest::QParseRequest( QParseFile* parseFile )
-	: QObject(QParse::instance())
+QParseRequest::QParseRequest( QParseFile* parseFile, QParse* client )
+	: QObject(QParse::parentForCurrentThread(client))
 	, parseClassName()
 	, parseObject(NULL)
+	, objectId()
 	, parseFile(parseFile)
 	, cacheControl(QParse::AlwaysCache)
-	, params() {
+	, params()
+	, body()
+	, deadline(0) {
 }
 
 void QParseRequest::addOption( QString name, QString value ) {
@@ -28,6 +35,22 @@ QList< QPair<QString,QString> > QParseRequest::getOptions() {
 	return params;
 }
 
+void QParseRequest::setDeadline( int msecs ) {
+	deadline = msecs;
+}
+
+int QParseRequest::getDeadline() const {
+	return deadline;
+}
+
+void QParseRequest::setBody( QJsonObject value ) {
+	body = value;
+}
+
+QJsonObject QParseRequest::getBody() const {
+	return body;
+}
+
 QParse::CacheControl QParseRequest::getCacheControl() const {
 	return cacheControl;
 }
@@ -52,6 +75,14 @@ void QParseRequest::setParseObject(QParseObject *value) {
 	parseObject = value;
 }
 
+QString QParseRequest::getObjectId() const {
+	return parseObject ? parseObject->getObjectId() : objectId;
+}
+
+void QParseRequest::setObjectId( QString value ) {
+	objectId = value;
+}
+
 QString QParseRequest::getParseClassName() const {
     return parseClassName;
 }
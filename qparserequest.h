@@ -5,6 +5,7 @@
 #include <QList>
 #include <QPair>
 #include <QString>
+#include <QJsonObject>
 #include "qparse.h"
 #include "qparsetypes.h"
 
@@ -31,19 +32,21 @@ public:
 	 *  \param parseClassName is the name of the Parse class used for creating the endpoint on the underlying
 	 *         REST API request.
 	 *  \note Some has special meaning for Parse and they will be handled by QParse:
-	 *        like _Users, login, logout
+	 *        like _Users, login, logout, batch
 	 *        but you don't worry about that because they are related to special classes
 	 *        which implementation is already provided by QParse library
+	 *  \param client the client that will send the request; NULL means QParse::instance()
 	 *  \warning it's responsability to the creator of QParseRequest to destroy it, but NEVER delete it explicity.
 	 *			 Instead, you MUST call the deleteLater() method on the associated QParseReply.
 	 */
-	QParseRequest( QString parseClassName );
+	QParseRequest( QString parseClassName, QParse* client=NULL );
 	/*! constructor a Parse File request
 	 *  \param QParseFile is the target of the request operation
+	 *  \param client the client that will send the request; NULL means QParse::instance()
 	 *  \warning it's responsability to the creator of QParseRequest to destroy it, but NEVER delete it explicity.
 	 *			 Instead, you MUST call the deleteLater() method on the associated QParseReply.
 	 */
-	QParseRequest( QParseFile* parseFile );
+	QParseRequest( QParseFile* parseFile, QParse* client=NULL );
 
 	//! return the class name used on PARSE for the target of this request
 	QString getParseClassName() const;
@@ -51,6 +54,11 @@ public:
 	QParseObject *getParseObject() const;
 	void setParseObject(QParseObject *value);
 
+	//! return the objectId of parseObject, or the one set with setObjectId when there is no parseObject
+	QString getObjectId() const;
+	//! set the objectId of the target object, for requests without a parseObject
+	void setObjectId( QString value );
+
 	QParseFile* getParseFile() const;
 	void setParseFile(QParseFile* value);
 
@@ -66,17 +74,37 @@ public:
 	//! return the list of all options added so far
 	QList< QPair<QString,QString> > getOptions();
 
+	/*! set the deadline of the request
+	 *  \param msecs if the request is not finished within msecs from its submission,
+	 *         it's aborted (see QParseReply::abort); 0, the default, means no deadline
+	 */
+	void setDeadline( int msecs );
+	int getDeadline() const;
+
+	/*! set the Json body to send on post and put requests
+	 *  When not empty, it's sent instead of the Json data of parseObject
+	 */
+	void setBody( QJsonObject value );
+	//! return the Json body set with setBody
+	QJsonObject getBody() const;
+
 private:
 	//! this is used to create the correct endpoint to network request
 	QString parseClassName;
 	//! the target object of this request
 	QParseObject* parseObject;
+	//! the id of the target object when there is no parseObject
+	QString objectId;
 	//! the parse file object of this request (if any)
 	QParseFile* parseFile;
 	//! the cache control to use
 	QParse::CacheControl cacheControl;
 	//! these are used for get network requests
 	QList< QPair<QString,QString> > params;
+	//! the body to send instead of the Json data of parseObject
+	QJsonObject body;
+	//! the milliseconds for finishing the request; 0 means no deadline
+	int deadline;
 };
 
 #endif // QPARSEREQUEST
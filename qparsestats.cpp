@@ -0,0 +1,140 @@
+
+#include "qparsestats.h"
+#include <QMutexLocker>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+
+QParseStats::QParseStats( QObject* parent )
+	: QObject(parent)
+	, mutex()
+	, enabled(true)
+	, endpoints()
+	, cacheHits()
+	, cacheMisses(0) {
+}
+
+bool QParseStats::isEnabled() const {
+	QMutexLocker locker( &mutex );
+	return enabled;
+}
+
+void QParseStats::setEnabled( bool value ) {
+	QMutexLocker locker( &mutex );
+	if ( enabled == value ) return;
+	enabled = value;
+	locker.unlock();
+	emit enabledChanged( value );
+}
+
+void QParseStats::record( QString endpoint, QString metric, double msecs ) {
+	QMutexLocker locker( &mutex );
+	if ( !enabled ) return;
+	Samples& samples = endpoints[endpoint].metrics[metric];
+	// the oldest samples are overwritten, so the percentiles are about the recent requests
+	if ( samples.values.size() < maxSamples ) {
+		samples.values.append( msecs );
+	} else {
+		samples.values[samples.next] = msecs;
+		samples.next = ( samples.next + 1 ) % maxSamples;
+	}
+	samples.count++;
+}
+
+void QParseStats::recordRequest( QString endpoint, bool failed ) {
+	QMutexLocker locker( &mutex );
+	if ( !enabled ) return;
+	Endpoint& data = endpoints[endpoint];
+	data.requests++;
+	if ( failed ) {
+		data.errors++;
+	}
+}
+
+void QParseStats::recordCacheHit( QString tier ) {
+	QMutexLocker locker( &mutex );
+	if ( !enabled ) return;
+	cacheHits[tier]++;
+}
+
+void QParseStats::recordCacheMiss() {
+	QMutexLocker locker( &mutex );
+	if ( !enabled ) return;
+	cacheMisses++;
+}
+
+QStringList QParseStats::getEndpoints() const {
+	QMutexLocker locker( &mutex );
+	return endpoints.keys();
+}
+
+QVariantMap QParseStats::getEndpointStats( QString endpoint ) const {
+	QMutexLocker locker( &mutex );
+	QVariantMap stats;
+	if ( !endpoints.contains(endpoint) ) return stats;
+	const Endpoint& data = endpoints[endpoint];
+	stats["requests"] = data.requests;
+	stats["errors"] = data.errors;
+	foreach( QString metric, data.metrics.keys() ) {
+		stats[metric] = summary( data.metrics[metric] );
+	}
+	return stats;
+}
+
+QVariantMap QParseStats::getCacheStats() const {
+	QMutexLocker locker( &mutex );
+	QVariantMap stats;
+	QVariantMap hits;
+	qint64 totalHits = 0;
+	foreach( QString tier, cacheHits.keys() ) {
+		hits[tier] = cacheHits[tier];
+		totalHits += cacheHits[tier];
+	}
+	stats["hits"] = hits;
+	stats["misses"] = cacheMisses;
+	qint64 total = totalHits + cacheMisses;
+	stats["hitRatio"] = total > 0 ? double(totalHits)/total : 0.0;
+	return stats;
+}
+
+QVariantMap QParseStats::toVariantMap() const {
+	QVariantMap stats;
+	QVariantMap endpointsStats;
+	foreach( QString endpoint, getEndpoints() ) {
+		endpointsStats[endpoint] = getEndpointStats( endpoint );
+	}
+	stats["endpoints"] = endpointsStats;
+	stats["cache"] = getCacheStats();
+	return stats;
+}
+
+QByteArray QParseStats::toJson() const {
+	return QJsonDocument( QJsonObject::fromVariantMap( toVariantMap() ) ).toJson();
+}
+
+void QParseStats::reset() {
+	QMutexLocker locker( &mutex );
+	endpoints.clear();
+	cacheHits.clear();
+	cacheMisses = 0;
+}
+
+QVariantMap QParseStats::summary( const Samples& samples ) {
+	QVariantMap stats;
+	QVector<double> sorted = samples.values;
+	std::sort( sorted.begin(), sorted.end() );
+	stats["count"] = samples.count;
+	if ( sorted.isEmpty() ) return stats;
+	double sum = 0;
+	foreach( double value, sorted ) {
+		sum += value;
+	}
+	// nearest-rank percentiles
+	int last = sorted.size()-1;
+	stats["mean"] = sum/sorted.size();
+	stats["p50"] = sorted[ qMin(last, int(sorted.size()*0.50)) ];
+	stats["p95"] = sorted[ qMin(last, int(sorted.size()*0.95)) ];
+	stats["p99"] = sorted[ qMin(last, int(sorted.size()*0.99)) ];
+	stats["max"] = sorted[last];
+	return stats;
+}
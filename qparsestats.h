@@ -0,0 +1,93 @@
+#ifndef QPARSESTATS_H
+#define QPARSESTATS_H
+
+#include <QObject>
+#include <QMap>
+#include <QVector>
+#include <QStringList>
+#include <QVariantMap>
+#include <QMutex>
+
+/*! It collects the timings of the requests and the usage of the cache of a client
+ *
+ *  For each endpoint (like "GET classes/Post", the objectId is not part of it)
+ *  it records the samples of these metrics, in milliseconds:
+ *    queueWait: from the submission to the processing by the dispatcher
+ *    throttleWait: from the processing to the sending on the network
+ *    ttfb: time to first byte, from the sending to the headers of the reply
+ *    download: from the headers to the end of the reply
+ *    jsonParse: the parsing of the Json data (from network or cache)
+ *    hydration: the creation of the objects from the Json data
+ *    total: from the submission to the finished signal of the reply
+ *  and it returns the percentiles p50, p95, p99 of the last samples
+ *
+ *  The cache hits are counted by tier: "disk" (cached by QParse), "pack" (bundled pack),
+ *  "bundled" (bundled cache directory) and "http" (QParseDiskCache); the misses are the get
+ *  requests sent to the network because not cached
+ *
+ *  \note DNS, connect and TLS timings are not available from QNetworkAccessManager of Qt 5;
+ *        they are part of ttfb (see also QParse::getConnectionStats)
+ *  \note it's thread-safe, the requests of all dispatchers record on it
+ */
+class QParseStats : public QObject {
+	Q_OBJECT
+	//! if false nothing is recorded
+	Q_PROPERTY( bool enabled READ isEnabled WRITE setEnabled NOTIFY enabledChanged )
+public:
+	QParseStats( QObject* parent=0 );
+	//! the number of samples kept for each metric of each endpoint
+	static const int maxSamples = 1024;
+public slots:
+	bool isEnabled() const;
+	void setEnabled( bool value );
+	//! add a sample of the metric of the endpoint
+	void record( QString endpoint, QString metric, double msecs );
+	//! count a request of the endpoint, and if it failed
+	void recordRequest( QString endpoint, bool failed );
+	//! count a hit on the tier of the cache
+	void recordCacheHit( QString tier );
+	//! count a miss of the cache
+	void recordCacheMiss();
+	//! return the endpoints recorded so far
+	QStringList getEndpoints() const;
+	/*! return the stats of the endpoint
+	 *  { "requests": n, "errors": n, "<metric>": { "count", "mean", "p50", "p95", "p99", "max" }, ... }
+	 */
+	QVariantMap getEndpointStats( QString endpoint ) const;
+	//! return { "hits": { "<tier>": n, ... }, "misses": n, "hitRatio": r }
+	QVariantMap getCacheStats() const;
+	//! return all the stats: { "endpoints": { "<endpoint>": {...} }, "cache": {...} }
+	QVariantMap toVariantMap() const;
+	//! return all the stats as Json (see toVariantMap)
+	QByteArray toJson() const;
+	//! discard all the stats
+	void reset();
+signals:
+	void enabledChanged( bool enabled );
+private:
+	//! the last samples of a metric
+	struct Samples {
+		Samples() : values(), next(0), count(0) { }
+		QVector<double> values;
+		//! where the next sample is written when the buffer is full
+		int next;
+		//! the number of samples recorded, also the ones discarded
+		qint64 count;
+	};
+	struct Endpoint {
+		Endpoint() : requests(0), errors(0), metrics() { }
+		qint64 requests;
+		qint64 errors;
+		QMap<QString, Samples> metrics;
+	};
+	//! return the summary of the samples
+	static QVariantMap summary( const Samples& samples );
+
+	mutable QMutex mutex;
+	bool enabled;
+	QMap<QString, Endpoint> endpoints;
+	QMap<QString, qint64> cacheHits;
+	qint64 cacheMisses;
+};
+
+#endif // QPARSESTATS_H
@@ -0,0 +1,130 @@
+
+#include "qparsethrottle.h"
+#include <QMutexLocker>
+#include <QtGlobal>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+#include <QRandomGenerator>
+#endif
+#include "qparselogging.h"
+
+//! the minimum limit of the requests in flight
+static const double minConcurrency = 1;
+//! the latency is considered grown when it's this factor of the minimum
+static const double latencyTolerance = 2.0;
+//! the milliseconds of a window of the minimum latency
+static const qint64 latencyWindow = 30000;
+//! the backoff of the first retry and the maximum one
+static const int baseBackoff = 500;
+static const int maxBackoff = 30000;
+
+QParseThrottle::QParseThrottle( QObject* parent )
+	: QObject(parent)
+	, mutex()
+	// no limit until the app sets the quota of its PARSE app (see QParse::requestRateLimit)
+	, rateLimit(0)
+	, tokens(0)
+	// the connections used by Qt for each host with HTTP/1.1, so it starts as without throttle
+	, concurrencyLimit(6)
+	, maxConcurrency(32)
+	, inFlight(0)
+	, minLatency(-1)
+	, previousMinLatency(-1) {
+	refillTimer.start();
+	windowTimer.start();
+}
+
+bool QParseThrottle::tryAcquire( int* waitMs ) {
+	QMutexLocker locker( &mutex );
+	if ( inFlight >= int(concurrencyLimit) ) {
+		*waitMs = -1;
+		return false;
+	}
+	if ( rateLimit > 0 ) {
+		refill();
+		if ( tokens < 1 ) {
+			*waitMs = qMax( 1, int((1-tokens)*1000/rateLimit) );
+			return false;
+		}
+		tokens -= 1;
+	}
+	inFlight++;
+	*waitMs = 0;
+	return true;
+}
+
+void QParseThrottle::release( qint64 latency, bool throttled ) {
+	QMutexLocker locker( &mutex );
+	inFlight = qMax( 0, inFlight-1 );
+	if ( throttled ) {
+		concurrencyLimit = qMax( minConcurrency, concurrencyLimit/2 );
+		// the tokens are not valid anymore, the quota is over
+		tokens = 0;
+		qparseDebug( qparseNetwork ) << "throttled by PARSE, concurrency limit" << int(concurrencyLimit);
+	} else if ( latency >= 0 ) {
+		if ( windowTimer.elapsed() > latencyWindow ) {
+			previousMinLatency = minLatency;
+			minLatency = -1;
+			windowTimer.restart();
+		}
+		if ( minLatency < 0 || latency < minLatency ) {
+			minLatency = latency;
+		}
+		qint64 baseLatency = previousMinLatency < 0 ? minLatency : qMin( minLatency, previousMinLatency );
+		// at least 1ms, or the latency of a local server would be never near enough
+		if ( latency <= qMax( qint64(1), baseLatency )*latencyTolerance ) {
+			// grows by one when a whole limit of requests succeeded
+			concurrencyLimit = qMin( maxConcurrency, concurrencyLimit + 1/concurrencyLimit );
+		} else {
+			concurrencyLimit = qMax( minConcurrency, concurrencyLimit*0.9 );
+		}
+	}
+	locker.unlock();
+	emit released();
+}
+
+int QParseThrottle::getBackoff( int retries ) {
+	int backoff = qMin( maxBackoff, baseBackoff << qMin(retries, 16) );
+	// equal jitter: a random time between half and the whole backoff
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+	return backoff/2 + int( QRandomGenerator::global()->bounded( backoff/2+1 ) );
+#else
+	return backoff/2 + qrand() % (backoff/2+1);
+#endif
+}
+
+double QParseThrottle::getRateLimit() const {
+	QMutexLocker locker( &mutex );
+	return rateLimit;
+}
+
+void QParseThrottle::setRateLimit( double value ) {
+	QMutexLocker locker( &mutex );
+	rateLimit = value;
+	tokens = qMin( tokens, qMax(1.0, rateLimit) );
+}
+
+int QParseThrottle::getConcurrencyLimit() const {
+	QMutexLocker locker( &mutex );
+	return int(concurrencyLimit);
+}
+
+int QParseThrottle::getMaxConcurrency() const {
+	QMutexLocker locker( &mutex );
+	return int(maxConcurrency);
+}
+
+void QParseThrottle::setMaxConcurrency( int value ) {
+	QMutexLocker locker( &mutex );
+	maxConcurrency = qMax( minConcurrency, double(value) );
+	concurrencyLimit = qMin( concurrencyLimit, maxConcurrency );
+}
+
+int QParseThrottle::getInFlight() const {
+	QMutexLocker locker( &mutex );
+	return inFlight;
+}
+
+void QParseThrottle::refill() {
+	// the burst is one second of requests (at least one request)
+	tokens = qMin( qMax(1.0, rateLimit), tokens + refillTimer.restart()*rateLimit/1000.0 );
+}
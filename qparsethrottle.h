@@ -0,0 +1,83 @@
+#ifndef QPARSETHROTTLE_H
+#define QPARSETHROTTLE_H
+
+#include <QObject>
+#include <QMutex>
+#include <QElapsedTimer>
+
+/*! It limits the requests sent to PARSE by a client
+ *
+ *  The rate of requests is limited by a token bucket: each request takes a token,
+ *  and the tokens are refilled at the rate limit up to a burst of one second of
+ *  requests; so the quota of requests per second of the PARSE app is never exceeded.
+ *  There is no rate limit by default
+ *
+ *  The number of requests in flight is adapted with AIMD (additive increase,
+ *  multiplicative decrease): the limit grows by one for each round of requests
+ *  while the latency holds near to the recent minimum, it shrinks slowly
+ *  when the latency grows, and it's halved when PARSE refuses a request for too many requests
+ *
+ *  The minimum is taken over a sliding window, so it follows the network when it
+ *  changes (e.g. from wifi to mobile) instead of keeping the best latency ever seen
+ *
+ *  It's shared by all the dispatchers of the client, so it's thread-safe
+ *
+ *  \warning Never create by yourself, it's created by QParse
+ */
+class QParseThrottle : public QObject {
+	Q_OBJECT
+public:
+	QParseThrottle( QObject* parent=0 );
+	/*! take a token for sending a request
+	 *  \param waitMs set to the milliseconds to wait for the next token, or to -1
+	 *         when too many requests are in flight (released will be emitted)
+	 *  \return true if the request can be sent
+	 */
+	bool tryAcquire( int* waitMs );
+	/*! the request has been completed
+	 *  \param latency the milliseconds from sending to the first byte of the reply;
+	 *         -1 when it is not a sample of the latency of PARSE (e.g. aborted requests)
+	 *  \param throttled true if PARSE refused the request for too many requests
+	 */
+	void release( qint64 latency, bool throttled );
+	/*! return the milliseconds to wait before sending again a throttled request
+	 *  It's exponential on the number of retries, with a random jitter
+	 *  so the retries of many requests are spread in time
+	 */
+	static int getBackoff( int retries );
+	//! the maximum number of retries of a throttled request
+	static const int maxRetries = 5;
+	//! the maximum number of requests per second; 0 means no limit
+	double getRateLimit() const;
+	void setRateLimit( double value );
+	//! the current limit of the requests in flight
+	int getConcurrencyLimit() const;
+	//! the maximum limit of the requests in flight reached by the additive increase
+	int getMaxConcurrency() const;
+	void setMaxConcurrency( int value );
+	int getInFlight() const;
+signals:
+	//! emitted when a request is completed, so a new one may be sent
+	void released();
+private:
+	//! add the tokens accumulated since the last refill
+	void refill();
+
+	mutable QMutex mutex;
+	double rateLimit;
+	double tokens;
+	QElapsedTimer refillTimer;
+	//! the limit of the requests in flight; fractional for the additive increase
+	double concurrencyLimit;
+	double maxConcurrency;
+	int inFlight;
+	/*! the minimum latency of the current window and of the previous one; the lower
+	 *  of them is taken as the latency of the network without queuing
+	 */
+	qint64 minLatency;
+	qint64 previousMinLatency;
+	//! the time since the start of the current window
+	QElapsedTimer windowTimer;
+};
+
+#endif // QPARSETHROTTLE_H
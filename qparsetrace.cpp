@@ -0,0 +1,129 @@
+
+#include "qparsetrace.h"
+#include <QAtomicPointer>
+#include <QElapsedTimer>
+#include <QSaveFile>
+#include <QCoreApplication>
+#include <atomic>
+
+/*! an event of the ring buffer
+ *  It's a seqlock: the fields are relaxed atomics, ordered with the state by the fences
+ */
+struct TraceEvent {
+	/*! 0 while the event is written, otherwise the ticket of the write (+1);
+	 *  the event is valid only when it's the same before and after reading it
+	 */
+	std::atomic<int> state;
+	std::atomic<const char*> name;
+	std::atomic<char> phase;
+	std::atomic<quint64> id;
+	std::atomic<qint64> timestamp;
+	std::atomic<qint64> duration;
+	std::atomic<int> thread;
+};
+
+QAtomicInt QParseTrace::enabled( 0 );
+//! the ring buffer; allocated the first time the trace is enabled, and never released
+static QAtomicPointer<TraceEvent> traceBuffer( NULL );
+//! the ticket of the next event to write
+static QAtomicInt traceNext( 0 );
+//! the number of threads seen so far, for giving them a small id
+static QAtomicInt traceThreads( 0 );
+
+//! return the time base of the trace
+static const QElapsedTimer& traceClock() {
+	static QElapsedTimer clock;
+	static bool started = ( clock.start(), true );
+	Q_UNUSED( started )
+	return clock;
+}
+
+void QParseTrace::setEnabled( bool value ) {
+	if ( value && !traceBuffer.loadAcquire() ) {
+		TraceEvent* buffer = new TraceEvent[capacity];
+		for( int i=0; i<capacity; i++ ) {
+			buffer[i].state.store( 0, std::memory_order_relaxed );
+		}
+		if ( !traceBuffer.testAndSetOrdered( NULL, buffer ) ) {
+			delete[] buffer;
+		}
+		traceClock();
+	}
+	enabled.storeRelease( value ? 1 : 0 );
+}
+
+void QParseTrace::record( const char* name, char phase, quint64 id, qint64 timestamp, qint64 duration ) {
+	TraceEvent* buffer = traceBuffer.loadAcquire();
+	if ( !buffer ) return;
+	static thread_local int thread = traceThreads.fetchAndAddRelaxed( 1 ) + 1;
+	int ticket = traceNext.fetchAndAddRelaxed( 1 );
+	// capacity is a power of two, so the modulo is right also when the ticket wraps around
+	TraceEvent& event = buffer[ uint(ticket) % uint(capacity) ];
+	event.state.store( 0, std::memory_order_relaxed );
+	// the fields cannot be written before the state is 0
+	std::atomic_thread_fence( std::memory_order_release );
+	event.name.store( name, std::memory_order_relaxed );
+	event.phase.store( phase, std::memory_order_relaxed );
+	event.id.store( id, std::memory_order_relaxed );
+	event.timestamp.store( timestamp < 0 ? now() : timestamp, std::memory_order_relaxed );
+	event.duration.store( duration, std::memory_order_relaxed );
+	event.thread.store( thread, std::memory_order_relaxed );
+	// the fields are written before the new state
+	event.state.store( (ticket & 0x7FFFFFFF) + 1, std::memory_order_release );
+}
+
+qint64 QParseTrace::now() {
+	return traceClock().nsecsElapsed() / 1000;
+}
+
+QByteArray QParseTrace::toChromeTrace() {
+	QByteArray json( "{\"traceEvents\":[" );
+	TraceEvent* buffer = traceBuffer.loadAcquire();
+	qint64 pid = QCoreApplication::applicationPid();
+	bool first = true;
+	for( int i=0; buffer && i<capacity; i++ ) {
+		TraceEvent& event = buffer[i];
+		int state = event.state.load( std::memory_order_acquire );
+		if ( state == 0 ) continue;
+		const char* name = event.name.load( std::memory_order_relaxed );
+		char phase = event.phase.load( std::memory_order_relaxed );
+		quint64 id = event.id.load( std::memory_order_relaxed );
+		qint64 timestamp = event.timestamp.load( std::memory_order_relaxed );
+		qint64 duration = event.duration.load( std::memory_order_relaxed );
+		int thread = event.thread.load( std::memory_order_relaxed );
+		// the fields are read before the state is checked again
+		std::atomic_thread_fence( std::memory_order_acquire );
+		// skip the event if it has been overwritten while reading it
+		if ( event.state.load( std::memory_order_relaxed ) != state ) continue;
+		QByteArray item = QString( "{\"name\":\"%1\",\"cat\":\"qparse\",\"ph\":\"%2\",\"ts\":%3,\"pid\":%4,\"tid\":%5" )
+				.arg( QString::fromLatin1(name) ).arg( QChar::fromLatin1(phase) )
+				.arg( timestamp ).arg( pid ).arg( thread ).toLatin1();
+		if ( phase == 'X' ) {
+			item += ",\"dur\":" + QByteArray::number( duration );
+		} else if ( phase == 'i' ) {
+			item += ",\"s\":\"t\"";
+		} else {
+			item += ",\"id\":\"0x" + QByteArray::number( id, 16 ) + "\"";
+		}
+		item += "}";
+		if ( !first ) json += ",\n";
+		json += item;
+		first = false;
+	}
+	json += "]}\n";
+	return json;
+}
+
+bool QParseTrace::save( QString filename ) {
+	QSaveFile file( filename );
+	if ( !file.open( QIODevice::WriteOnly ) ) return false;
+	file.write( toChromeTrace() );
+	return file.commit();
+}
+
+void QParseTrace::clear() {
+	TraceEvent* buffer = traceBuffer.loadAcquire();
+	for( int i=0; buffer && i<capacity; i++ ) {
+		buffer[i].state.store( 0, std::memory_order_release );
+	}
+}
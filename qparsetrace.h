@@ -0,0 +1,85 @@
+#ifndef QPARSETRACE_H
+#define QPARSETRACE_H
+
+#include <QtGlobal>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QString>
+
+/*! It records the stages of the requests as trace events, exportable in the Chrome trace format
+ *  (open the file in chrome://tracing or https://ui.perfetto.dev)
+ *
+ *  Each request is an async event "request" from the submission to the finished signal,
+ *  with the steps "dispatch", "send" and "networkFinished"; the work done on a thread
+ *  (updateCache, fillWithCachedData, hydration) are complete events with their duration
+ *
+ *  The events are written into a ring buffer without locks, so the recording threads never
+ *  wait each other; when the buffer is full, the oldest events are overwritten
+ *
+ *  It's disabled by default: when disabled, the cost of an event is the check of one flag,
+ *  so it can be shipped in release builds and enabled in the field
+ *
+ *  \code
+ *  QParseTrace::setEnabled( true );
+ *  ...
+ *  QParseTrace::save( "qparse-trace.json" );
+ *  \endcode
+ */
+class QParseTrace {
+public:
+	//! the number of events kept
+	static const int capacity = 16384;
+	//! true if the events are recorded
+	static inline bool isEnabled() {
+		return enabled.load() != 0;
+	}
+	static void setEnabled( bool value );
+	/*! record an event
+	 *  \param name must be a string literal, it's not copied
+	 *  \param phase the phase of the Chrome trace format: 'b' async begin, 'n' async step,
+	 *         'e' async end, 'X' complete, 'i' instant
+	 *  \param id the id of the async events; the events of the same request have the same id
+	 *  \param timestamp the microseconds from the start of the trace (see now);
+	 *         -1 means now
+	 *  \param duration the microseconds of the complete events
+	 */
+	static void record( const char* name, char phase, quint64 id=0, qint64 timestamp=-1, qint64 duration=0 );
+	//! return the microseconds from the start of the trace
+	static qint64 now();
+	//! return the events recorded in the Chrome trace Json format
+	static QByteArray toChromeTrace();
+	//! write the events recorded on the file in the Chrome trace Json format
+	static bool save( QString filename );
+	//! discard all the events recorded
+	static void clear();
+private:
+	static QAtomicInt enabled;
+};
+
+/*! It records a complete event with the duration of the scope where it's declared
+ *  \code
+ *  void QParse::updateCache(...) {
+ *      QParseTraceScope trace( "updateCache" );
+ *  \endcode
+ */
+class QParseTraceScope {
+public:
+	inline QParseTraceScope( const char* name )
+		: name(name)
+		, start(QParseTrace::isEnabled() ? QParseTrace::now() : -1) { }
+	inline ~QParseTraceScope() {
+		if ( start >= 0 ) {
+			QParseTrace::record( name, 'X', 0, start, QParseTrace::now()-start );
+		}
+	}
+private:
+	Q_DISABLE_COPY( QParseTraceScope )
+	const char* name;
+	qint64 start;
+};
+
+//! record an event of the request identified by id, only when the trace is enabled
+#define QPARSE_TRACE( name, phase, id ) \
+	do { if ( QParseTrace::isEnabled() ) QParseTrace::record( name, phase, quint64(quintptr(id)) ); } while(0)
+
+#endif // QPARSETRACE_H
@@ -0,0 +1,27 @@
+
+#include "qparsetransport.h"
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+
+QParseTransport::QParseTransport( QObject* parent )
+	: QObject(parent) {
+}
+
+QParseNetworkTransport::QParseNetworkTransport( QNetworkAccessManager* net, QObject* parent )
+	: QParseTransport(parent)
+	, net(net) {
+	connect( net, &QNetworkAccessManager::finished, this, &QParseTransport::finished );
+}
+
+QNetworkReply* QParseNetworkTransport::send( QByteArray method, const QNetworkRequest& request, QByteArray body ) {
+	if ( method == "GET" ) {
+		return net->get( request );
+	} else if ( method == "POST" ) {
+		return net->post( request, body );
+	} else if ( method == "PUT" ) {
+		return net->put( request, body );
+	} else if ( method == "DELETE" ) {
+		return net->deleteResource( request );
+	}
+	return net->sendCustomRequest( request, method );
+}
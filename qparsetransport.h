@@ -0,0 +1,59 @@
+#ifndef QPARSETRANSPORT_H
+#define QPARSETRANSPORT_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QNetworkRequest>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+/*! It sends the requests of a dispatcher and returns their replies
+ *
+ *  QParse prepares the requests (see QParse::processOperationsQueue) and processes
+ *  the replies (see QParse::onRequestFinished) always in the same way; the transport
+ *  is only how the bytes go to PARSE and back. The default one is the network
+ *  (QParseNetworkTransport); QParseMemoryTransport replies from memory, without sockets
+ *
+ *  Each dispatcher has its own transport, created on the thread of the dispatcher
+ *  by the factory set with QParse::setTransportFactory
+ */
+class QParseTransport : public QObject {
+	Q_OBJECT
+public:
+	QParseTransport( QObject* parent=0 );
+	/*! send the request
+	 *  \param method GET, POST, PUT or DELETE
+	 *  \param body the body of POST and PUT
+	 *  \return the reply; the transport emits finished when it's complete
+	 */
+	virtual QNetworkReply* send( QByteArray method, const QNetworkRequest& request, QByteArray body ) = 0;
+signals:
+	//! emitted when the reply is complete (also with an error)
+	void finished( QNetworkReply* reply );
+};
+
+//! It creates the transports of the dispatchers (see QParse::setTransportFactory)
+class QParseTransportFactory {
+public:
+	virtual ~QParseTransportFactory() { }
+	/*! return a new transport, owned by parent
+	 *  \note it's called from the threads of the dispatchers, so it has to be thread-safe
+	 */
+	virtual QParseTransport* create( QObject* parent ) = 0;
+};
+
+/*! The transport sending the requests to PARSE over the network
+ *  It forwards also the replies of the requests sent directly on the network manager,
+ *  like the installation and the app config ones
+ */
+class QParseNetworkTransport : public QParseTransport {
+	Q_OBJECT
+public:
+	QParseNetworkTransport( QNetworkAccessManager* net, QObject* parent=0 );
+	virtual QNetworkReply* send( QByteArray method, const QNetworkRequest& request, QByteArray body );
+private:
+	QNetworkAccessManager* net;
+};
+
+#endif // QPARSETRANSPORT_H
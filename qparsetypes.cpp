@@ -3,7 +3,7 @@
 #include "qparsetypes.h"
 #include "qparsereply.h"
 #include "qparserequest.h"
-#include <QDebug>
+#include "qparselogging.h"
 
 QParseDate::QParseDate()
 	: json()
@@ -19,7 +19,7 @@ QParseDate::QParseDate( QJsonObject fromParse )
 	: json()
 	, dateTime() {
 	if ( !fromParse.contains("__type") || !fromParse.contains("iso") ) {
-		qDebug("QParseDate - wrong Json format passed to constructor");
+		qparseWarning( qparseQuery ) << "QParseDate - wrong Json format passed to constructor" << qparseLoggedPayload( fromParse );
 		return;
 	}
 	json = fromParse;
@@ -91,8 +91,7 @@ QParseFile::QParseFile( QJsonObject fromParse, QObject* parent )
 	// one containing the __type and one not containing the __type
 	// so, check only the presence of name and url
 	if ( !fromParse.contains("url") || !fromParse.contains("name") ) {
-		qDebug() << "FROM PARSE:" << fromParse;
-		qDebug("QParseFile - wrong Json format passed to constructor");
+		qparseWarning( qparseQuery ) << "QParseFile - wrong Json format passed to constructor" << qparseLoggedPayload( fromParse );
 		status = NotValid;
 		return;
 	}
@@ -168,7 +167,14 @@ void QParseFile::pull() {
 		setStatus( Caching );
 		QParseRequest* request = new QParseRequest(this);
 		QParseReply* reply = QParse::instance()->get( request );
-		connect( reply, &QParseReply::finished, [this](QParseReply* reply) {
+		// when the file is destroyed (like a delegate scrolled off screen) the download is cancelled
+		reply->setOwner( this );
+		connect( reply, &QParseReply::finished, this, [this](QParseReply* reply) {
+			reply->deleteLater();
+			if ( reply->getHasError() ) {
+				setStatus( NotCached );
+				return;
+			}
 			setLocalUrl( reply->getLocalUrl() );
 			setStatus( Cached );
 			emit cached( localUrl );
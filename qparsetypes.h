@@ -90,7 +90,9 @@ public slots:
 	Status getStatus() const;
 	void setStatus(const Status &value);
 
-	/*! send a request for caching the file */
+	/*! send a request for caching the file
+	 *  The request is cancelled if the QParseFile is destroyed before the file is cached
+	 */
 	void pull();
 signals:
 	void localUrlChanged( QUrl localUrl );
@@ -1,7 +1,6 @@
 
 #include "qparse.h"
 #include "qparseuser.h"
-#include <QDebug>
 
 QString QParseUser::getToken() const {
 	return token;
@@ -10,7 +10,22 @@ SOURCES += \
 	$$PWD/qparseuser.cpp \
 	$$PWD/qparserequest.cpp \
 	$$PWD/qparsereply.cpp \
-	$$PWD/qparsequery.cpp
+	$$PWD/qparsequery.cpp \
+	$$PWD/qparsecacheworker.cpp \
+	$$PWD/qparsepack.cpp \
+	$$PWD/qparsedispatcher.cpp \
+	$$PWD/qparsebatch.cpp \
+	$$PWD/qparseprefetch.cpp \
+	$$PWD/qparseoutbox.cpp \
+	$$PWD/qparsethrottle.cpp \
+	$$PWD/qparsestats.cpp \
+	$$PWD/qparsetrace.cpp \
+	$$PWD/qparselogging.cpp \
+	$$PWD/qparsecapture.cpp \
+	$$PWD/qparsereplay.cpp \
+	$$PWD/qparsetransport.cpp \
+	$$PWD/qparsememorytransport.cpp \
+	$$PWD/qparsediskcache.cpp
 
 HEADERS += \
 	$$PWD/qparsetypes.h \
@@ -19,7 +34,23 @@ HEADERS += \
 	$$PWD/qparseuser.h \
 	$$PWD/qparserequest.h \
 	$$PWD/qparsereply.h \
-	$$PWD/qparsequery.h
+	$$PWD/qparsequery.h \
+	$$PWD/qparsecacheworker.h \
+	$$PWD/qparsepack.h \
+	$$PWD/qparsedispatcher.h \
+	$$PWD/qparsebatch.h \
+	$$PWD/qparseprefetch.h \
+	$$PWD/qparseoutbox.h \
+	$$PWD/qparsethrottle.h \
+	$$PWD/qparsestats.h \
+	$$PWD/qparsetrace.h \
+	$$PWD/qparselogging.h \
+	$$PWD/qparsecapture.h \
+	$$PWD/qparsereplay.h \
+	$$PWD/qparsetransport.h \
+	$$PWD/qparsememorytransport.h \
+	$$PWD/qparsediskcache.h \
+	$$PWD/qparsefuture.h
 
 android {
 	QT += androidextras
@@ -28,4 +59,7 @@ android {
 	## the objective sources should be put in this variable
 	OBJECTIVE_SOURCES += \
 		$$PWD/qparse_ios.mm
+} else {
+	## desktop builds (like the tools) have no push notifications
+	SOURCES += $$PWD/qparse_desktop.cpp
 }
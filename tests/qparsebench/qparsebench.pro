@@ -0,0 +1,13 @@
+QT += core network qml testlib
+QT -= gui
+
+CONFIG += console c++11 testcase
+CONFIG -= app_bundle
+
+TARGET = qparsebench
+TEMPLATE = app
+
+include( $$PWD/../../qtparse.pri )
+
+SOURCES += \
+	$$PWD/tst_qparsebench.cpp
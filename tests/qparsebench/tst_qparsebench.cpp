@@ -0,0 +1,339 @@
+#include "qparse.h"
+#include "qparseobject.h"
+#include "qparsequery.h"
+#include "qparsereply.h"
+#include "qparserequest.h"
+#include "qparsetypes.h"
+#include "qparsecacheworker.h"
+#include <QtTest>
+#include <QStandardPaths>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDir>
+#include <QFileInfo>
+
+/*! qparsebench: micro-benchmarks of the hot paths of QParse
+ *
+ *  The benchmarks run the code of QParse, not a copy of it:
+ *    toJson: QParseObject::toJson of wide objects
+ *    dateParse, dateFormat: parsing and formatting of QParseDate
+ *    hydration: QParseQuery creating the objects of the results of a query
+ *    cacheRoundTrip: QParse::updateCache of a reply and QParse::fillWithCachedData of it
+ *    cacheFootprint: the bytes on disk for each entry of the cache, raw and compressed
+ *    loadCacheInfoData: QParse::loadCacheInfoData of large cache indexes
+ *
+ *  The results are written in the formats of QtTest, so the outputs of two releases
+ *  can be compared for catching regressions:
+ *  \code
+ *  qparsebench -o before.xml,xml
+ *  qparsebench -csv hydration
+ *  \endcode
+ */
+
+//! an object with a configurable number of plain properties
+class BenchObject : public QParseObject {
+	Q_OBJECT
+public:
+	BenchObject( QObject* parent=0 )
+		: QParseObject(parent) { }
+	Q_INVOKABLE BenchObject( QJsonObject jsonData, QObject* parent=0 )
+		: QParseObject(jsonData, parent) { }
+	virtual QString parseClassName() { return "BenchObject"; }
+	virtual QStringList parseProperties() { return properties; }
+	static QStringList properties;
+};
+QStringList BenchObject::properties;
+
+static void setWidth( int width ) {
+	BenchObject::properties.clear();
+	for( int i=0; i<width; i++ ) {
+		BenchObject::properties << QString("field%1").arg(i);
+	}
+}
+
+//! return the Json of an object like returned by PARSE with the properties of BenchObject
+static QJsonObject objectJson( int index ) {
+	QJsonObject data;
+	data["objectId"] = QString("obj%1").arg(index, 8, 10, QChar('0'));
+	data["createdAt"] = "2016-03-01T10:20:30.456Z";
+	data["updatedAt"] = "2016-03-02T11:22:33.789Z";
+	for( int i=0; i<BenchObject::properties.size(); i++ ) {
+		switch( i%4 ) {
+		case 0: data[BenchObject::properties[i]] = QString("value %1 of %2").arg(i).arg(index); break;
+		case 1: data[BenchObject::properties[i]] = index*i; break;
+		case 2: data[BenchObject::properties[i]] = (i+index)%2 == 0; break;
+		case 3: data[BenchObject::properties[i]] = QParseDate( QDateTime::currentDateTimeUtc() ).toJson(); break;
+		}
+	}
+	return data;
+}
+
+//! return the raw data of the results of a query like returned by PARSE
+static QByteArray queryResults( int rows ) {
+	QJsonArray results;
+	for( int i=0; i<rows; i++ ) {
+		results.append( objectJson(i) );
+	}
+	QJsonObject data;
+	data["results"] = results;
+	return QJsonDocument(data).toJson( QJsonDocument::Compact );
+}
+
+class QParseBenchmark : public QObject {
+	Q_OBJECT
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void toJson_data();
+	void toJson();
+	void dateParse_data();
+	void dateParse();
+	void dateFormat_data();
+	void dateFormat();
+	void hydration_data();
+	void hydration();
+	void cacheRoundTrip_data();
+	void cacheRoundTrip();
+	void cacheFootprint_data();
+	void cacheFootprint();
+	void loadCacheInfoData_data();
+	void loadCacheInfoData();
+private:
+	//! the client of the benchmarks, with its own cache directory
+	QParse* parse;
+};
+
+void QParseBenchmark::initTestCase() {
+	QStandardPaths::setTestModeEnabled( true );
+	QDir( QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)+"/QParseCache/qparsebench" ).removeRecursively();
+	parse = new QParse( "qparsebench" );
+	QTRY_VERIFY( parse->isReady() );
+}
+
+void QParseBenchmark::cleanupTestCase() {
+	QString cacheDir = parse->cacheDir;
+	delete parse;
+	QDir( cacheDir ).removeRecursively();
+}
+
+void QParseBenchmark::toJson_data() {
+	QTest::addColumn<int>( "width" );
+	QTest::newRow( "8" ) << 8;
+	QTest::newRow( "64" ) << 64;
+	QTest::newRow( "256" ) << 256;
+}
+
+void QParseBenchmark::toJson() {
+	QFETCH( int, width );
+	setWidth( width );
+	BenchObject object( objectJson(1) );
+	object.fromJson( objectJson(1) );
+	QBENCHMARK {
+		QJsonObject data = object.toJson();
+		Q_UNUSED( data )
+	}
+}
+
+void QParseBenchmark::dateParse_data() {
+	QTest::addColumn<bool>( "fromJson" );
+	QTest::newRow( "iso" ) << false;
+	QTest::newRow( "json" ) << true;
+}
+
+void QParseBenchmark::dateParse() {
+	QFETCH( bool, fromJson );
+	QString iso = "2016-03-01T10:20:30.456Z";
+	QJsonObject json = QParseDate( iso ).toJson();
+	if ( fromJson ) {
+		QBENCHMARK {
+			QParseDate parsed( json );
+			Q_UNUSED( parsed )
+		}
+	} else {
+		QBENCHMARK {
+			QParseDate parsed( iso );
+			Q_UNUSED( parsed )
+		}
+	}
+}
+
+void QParseBenchmark::dateFormat_data() {
+	dateParse_data();
+}
+
+void QParseBenchmark::dateFormat() {
+	QFETCH( bool, fromJson );
+	QParseDate date( QString("2016-03-01T10:20:30.456Z") );
+	if ( fromJson ) {
+		QBENCHMARK {
+			QJsonObject formatted = date.toJson();
+			Q_UNUSED( formatted )
+		}
+	} else {
+		QBENCHMARK {
+			QString formatted = date.toISO();
+			Q_UNUSED( formatted )
+		}
+	}
+}
+
+void QParseBenchmark::hydration_data() {
+	QTest::addColumn<int>( "rows" );
+	QTest::newRow( "1k" ) << 1000;
+	QTest::newRow( "10k" ) << 10000;
+	QTest::newRow( "100k" ) << 100000;
+}
+
+void QParseBenchmark::hydration() {
+	QFETCH( int, rows );
+	setWidth( 16 );
+	QJsonObject results = QJsonDocument::fromJson( queryResults(rows) ).object();
+	QParseQuery* query = QParseQuery::create<BenchObject>( "BenchObject", parse );
+	int hydrated = 0;
+	// the objects are deleted at once, or the rows of all the iterations would pile up
+	connect( query, &QParseQuery::queryResults, [&hydrated]( QList<QParseObject*> objects ) {
+		hydrated = objects.size();
+		qDeleteAll( objects );
+	} );
+	QBENCHMARK {
+		QParseReply* reply = new QParseReply( NULL, parse );
+		reply->setJson( results );
+		// the reply of PARSE handled by the query
+		QMetaObject::invokeMethod( query, "onQueryReply", Qt::DirectConnection, Q_ARG(QParseReply*, reply) );
+	}
+	QCOMPARE( hydrated, rows );
+	delete query;
+	QCoreApplication::sendPostedEvents( NULL, QEvent::DeferredDelete );
+}
+
+void QParseBenchmark::cacheRoundTrip_data() {
+	QTest::addColumn<int>( "rows" );
+	QTest::addColumn<bool>( "compression" );
+	QTest::newRow( "10/raw" ) << 10 << false;
+	QTest::newRow( "10/zlib" ) << 10 << true;
+	QTest::newRow( "1000/raw" ) << 1000 << false;
+	QTest::newRow( "1000/zlib" ) << 1000 << true;
+}
+
+void QParseBenchmark::cacheRoundTrip() {
+	QFETCH( int, rows );
+	QFETCH( bool, compression );
+	setWidth( 16 );
+	QByteArray rawData = queryResults( rows );
+	bool previousCompression = parse->getCacheCompression();
+	int previousThreshold = parse->getCacheCompressionThreshold();
+	parse->setCacheCompression( compression );
+	parse->setCacheCompressionThreshold( 0 );
+	QUrl url( QString("https://api.parse.com/1/classes/BenchObject?rows=%1&compression=%2").arg(rows).arg(compression) );
+	QParseRequest request( "BenchObject", parse );
+	int iteration = 0;
+	QBENCHMARK {
+		// the blobs are stored by content, so the data of each iteration is different
+		// or the worker would skip writing the blob already on disk
+		QByteArray data = rawData;
+		data.insert( data.size()-1, QString(",\"iteration\":%1").arg(iteration++).toLatin1() );
+		// the operation is deleted when its reply is finished
+		QParse::OperationData* opdata = new QParse::OperationData();
+		QParseReply* reply = new QParseReply( &request, parse );
+		opdata->parseReply = reply;
+		opdata->submittedTimer.start();
+		// the reply of PARSE cached by onRequestFinished, and written on disk by the worker
+		parse->updateCache( url, data, opdata );
+		QMetaObject::invokeMethod( parse->cacheWorker, "flush", Qt::BlockingQueuedConnection );
+		// the same request served from the cache
+		QSignalSpy finished( reply, &QParseReply::finished );
+		parse->fillWithCachedData( url, opdata );
+		QVERIFY( finished.wait() );
+		QVERIFY( !reply->getHasError() );
+		delete reply;
+	}
+	parse->setCacheCompression( previousCompression );
+	parse->setCacheCompressionThreshold( previousThreshold );
+}
+
+void QParseBenchmark::cacheFootprint_data() {
+	cacheRoundTrip_data();
+}
+
+void QParseBenchmark::cacheFootprint() {
+	QFETCH( int, rows );
+	QFETCH( bool, compression );
+	setWidth( 16 );
+	bool previousCompression = parse->getCacheCompression();
+	int previousThreshold = parse->getCacheCompressionThreshold();
+	parse->setCacheCompression( compression );
+	parse->setCacheCompressionThreshold( 0 );
+	// the pages of a query, so the entries have different data like on a real cache
+	const int entries = 20;
+	QList<QUrl> urls;
+	for( int i=0; i<entries; i++ ) {
+		QJsonArray results;
+		for( int j=0; j<rows; j++ ) {
+			results.append( objectJson(i*rows+j) );
+		}
+		QJsonObject data;
+		data["results"] = results;
+		QUrl url( QString("https://api.parse.com/1/classes/BenchObject?rows=%1&skip=%2").arg(rows).arg(i*rows) );
+		parse->updateCache( url, QJsonDocument(data).toJson(QJsonDocument::Compact), NULL );
+		urls << url;
+	}
+	QMetaObject::invokeMethod( parse->cacheWorker, "flush", Qt::BlockingQueuedConnection );
+	qint64 bytes = 0;
+	foreach( QUrl url, urls ) {
+		QFileInfo blob( parse->cache[url].localFile.toLocalFile() );
+		QVERIFY( blob.exists() );
+		bytes += blob.size();
+	}
+	// there is no metric for the disk, the bytes are reported like the allocated ones
+	QTest::setBenchmarkResult( bytes/entries, QTest::BytesAllocated );
+	foreach( QUrl url, urls ) {
+		parse->removeCacheEntry( url );
+	}
+	QMetaObject::invokeMethod( parse->cacheWorker, "flush", Qt::BlockingQueuedConnection );
+	parse->setCacheCompression( previousCompression );
+	parse->setCacheCompressionThreshold( previousThreshold );
+}
+
+void QParseBenchmark::loadCacheInfoData_data() {
+	QTest::addColumn<int>( "entries" );
+	QTest::newRow( "1k" ) << 1000;
+	QTest::newRow( "10k" ) << 10000;
+}
+
+void QParseBenchmark::loadCacheInfoData() {
+	QFETCH( int, entries );
+	// the index like written by saveCacheInfoData
+	QVariantList index;
+	for( int i=0; i<entries; i++ ) {
+		QVariantMap entry;
+		entry["url"] = QUrl( QString("https://api.parse.com/1/classes/BenchObject/obj%1").arg(i) );
+		entry["isJson"] = true;
+		entry["localFile"] = QString("%1.json").arg(i);
+		entry["createdAt"] = QDateTime::currentDateTimeUtc();
+		entry["bundled"] = false;
+		entry["codec"] = QString();
+		index << entry;
+	}
+	QMetaObject::invokeMethod( parse->cacheWorker, "writeIndex", Qt::BlockingQueuedConnection,
+							   Q_ARG(QString, parse->cacheDir+"/"+parse->cacheIni),
+							   Q_ARG(QVariantList, index) );
+	QMetaObject::invokeMethod( parse->cacheWorker, "flush", Qt::BlockingQueuedConnection );
+	QBENCHMARK {
+		// the index is loaded into an empty cache, like on startup
+		parse->cacheLock.lockForWrite();
+		parse->cache.clear();
+		parse->cacheBlobRefs.clear();
+		parse->cacheLock.unlock();
+		// the index is loaded by the worker and built into the cache by onCacheIndexLoaded
+		QSignalSpy ready( parse, &QParse::readyChanged );
+		parse->loadCacheInfoData();
+		QVERIFY( ready.wait() );
+	}
+	QCOMPARE( parse->cache.size(), entries );
+	QCOMPARE( parse->cacheBlobRefs.size(), entries );
+}
+
+QTEST_GUILESS_MAIN( QParseBenchmark )
+
+#include "tst_qparsebench.moc"
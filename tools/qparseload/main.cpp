@@ -0,0 +1,448 @@
+#include "qparse.h"
+#include "qparserequest.h"
+#include "qparsereply.h"
+#include "qparsetypes.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QThread>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QFile>
+#include <QTextStream>
+#include <QVector>
+#include <QMap>
+#include <QAtomicInt>
+#include <QDebug>
+#include <QtGlobal>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+#include <QRandomGenerator>
+#endif
+#include <algorithm>
+#include <ctime>
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+/*! qparseload: a load generator built on QParse
+ *
+ *  It creates N independent clients (each one with its own cache namespace) spread over
+ *  M threads; each client runs some sessions that submit a scripted mix of operations
+ *  one after the other (closed loop), with an optional think time between them:
+ *    query: a query of the class with a limit
+ *    save: the creation of an object of the class
+ *    file: the download of a file
+ *  At the end it reports the throughput, the latency percentiles of each operation,
+ *  the memory used by each client and the CPU time spent for each request
+ */
+
+//! the settings of the load, shared by all the workers
+struct LoadSettings {
+	QUrl baseUrl;
+	QString appId;
+	QString restKey;
+	QString className;
+	int limit;
+	QUrl fileUrl;
+	//! the operations and their weights
+	QMap<QString, int> mix;
+	int sessions;
+	int think;
+	bool useCache;
+	double rateLimit;
+};
+
+//! return a random number between 0 and max-1
+static int random( int max ) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+	return int( QRandomGenerator::global()->bounded( max ) );
+#else
+	return qrand() % max;
+#endif
+}
+
+//! return the resident memory of the process in bytes, or -1 if not available
+static qint64 residentMemory() {
+#ifdef Q_OS_LINUX
+	QFile statm( "/proc/self/statm" );
+	if ( statm.open( QIODevice::ReadOnly ) ) {
+		QList<QByteArray> values = statm.readAll().split( ' ' );
+		if ( values.size() > 1 ) {
+			return values[1].toLongLong() * 4096;
+		}
+	}
+#endif
+	return -1;
+}
+
+//! return the CPU time used by the process in milliseconds
+static double cpuTime() {
+#ifdef Q_OS_UNIX
+	struct rusage usage;
+	getrusage( RUSAGE_SELF, &usage );
+	return ( usage.ru_utime.tv_sec + usage.ru_stime.tv_sec )*1000.0 +
+		   ( usage.ru_utime.tv_usec + usage.ru_stime.tv_usec )/1000.0;
+#else
+	return std::clock()*1000.0/CLOCKS_PER_SEC;
+#endif
+}
+
+/*! It runs the clients of a thread
+ *  The clients are created on the thread of the worker, so their requests are dispatched from it
+ */
+class LoadWorker : public QObject {
+	Q_OBJECT
+public:
+	LoadWorker( LoadSettings settings, QList<int> clientIds )
+		: QObject(NULL)
+		, settings(settings)
+		, clientIds(clientIds)
+		, clients()
+		, totalWeight(0)
+		, inFlight(0)
+		, stopping(false)
+		, recording(false)
+		, latencies()
+		, errors() {
+		foreach( QString op, settings.mix.keys() ) {
+			totalWeight += settings.mix[op];
+		}
+	}
+public slots:
+	//! create the clients; created is emitted when done
+	void createClients() {
+		foreach( int id, clientIds ) {
+			QParse* client = new QParse( QString("qparseload/%1").arg(id), this );
+			client->setBaseUrl( settings.baseUrl );
+			client->setAppId( settings.appId );
+			client->setRestKey( settings.restKey );
+			client->setRequestRateLimit( settings.rateLimit );
+			clients << client;
+		}
+		emit created();
+	}
+	void start() {
+		foreach( QParse* client, clients ) {
+			for( int i=0; i<settings.sessions; i++ ) {
+				next( client );
+			}
+		}
+	}
+	//! start recording the latencies (after the warm up)
+	void record() {
+		recording = true;
+	}
+	//! stop submitting; stopped is emitted when the requests in flight are finished
+	void stop() {
+		stopping = true;
+		if ( inFlight == 0 ) {
+			emit stopped( results() );
+		}
+	}
+signals:
+	void created();
+	void stopped( QVariantMap results );
+private:
+	//! submit the next operation of a session of the client
+	void next( QParse* client ) {
+		if ( stopping ) return;
+		QString op = pick();
+		QParseRequest* request;
+		QParseReply* reply;
+		if ( op == "save" ) {
+			request = new QParseRequest( settings.className, client );
+			QJsonObject body;
+			body["score"] = random( 1000000 );
+			body["name"] = QString("load %1").arg( random(1000000) );
+			request->setBody( body );
+			reply = client->post( request );
+		} else if ( op == "file" ) {
+			QJsonObject fileJson;
+			fileJson["name"] = settings.fileUrl.fileName();
+			fileJson["url"] = settings.fileUrl.toString();
+			request = new QParseRequest( new QParseFile( fileJson ), client );
+			request->getParseFile()->setParent( request );
+			request->setCacheControl( settings.useCache ? QParse::AlwaysCache : QParse::AlwaysNetwork );
+			reply = client->get( request );
+		} else {
+			request = new QParseRequest( settings.className, client );
+			request->addOption( "limit", QString::number(settings.limit) );
+			request->addOption( "order", "-createdAt" );
+			request->setCacheControl( settings.useCache ? QParse::AlwaysCache : QParse::AlwaysNetwork );
+			reply = client->get( request );
+		}
+		inFlight++;
+		QElapsedTimer* timer = new QElapsedTimer();
+		timer->start();
+		connect( reply, &QParseReply::finished, this, [this, client, op, timer]( QParseReply* reply ) {
+			if ( recording ) {
+				latencies[op] << timer->nsecsElapsed()/1000000.0;
+				if ( reply->getHasError() ) {
+					errors[op]++;
+				}
+			}
+			delete timer;
+			reply->deleteLater();
+			inFlight--;
+			if ( stopping ) {
+				if ( inFlight == 0 ) {
+					emit stopped( results() );
+				}
+				return;
+			}
+			QTimer::singleShot( settings.think, this, [this, client]() {
+				next( client );
+			});
+		});
+	}
+	//! return an operation of the mix, by weight
+	QString pick() {
+		int value = random( totalWeight );
+		foreach( QString op, settings.mix.keys() ) {
+			value -= settings.mix[op];
+			if ( value < 0 ) return op;
+		}
+		return settings.mix.firstKey();
+	}
+	QVariantMap results() {
+		QVariantMap data;
+		foreach( QString op, latencies.keys() ) {
+			QVariantList values;
+			foreach( double value, latencies[op] ) {
+				values << value;
+			}
+			QVariantMap opData;
+			opData["latencies"] = values;
+			opData["errors"] = errors.value(op);
+			data[op] = opData;
+		}
+		return data;
+	}
+
+	LoadSettings settings;
+	QList<int> clientIds;
+	QList<QParse*> clients;
+	int totalWeight;
+	int inFlight;
+	bool stopping;
+	bool recording;
+	//! the milliseconds of each operation completed while recording
+	QMap<QString, QVector<double> > latencies;
+	QMap<QString, int> errors;
+};
+
+//! return the percentile of the sorted values (nearest rank)
+static double percentile( const QVector<double>& sorted, double p ) {
+	if ( sorted.isEmpty() ) return 0;
+	return sorted[ qMin( sorted.size()-1, int(sorted.size()*p) ) ];
+}
+
+int main( int argc, char *argv[] ) {
+	QCoreApplication app( argc, argv );
+	QCoreApplication::setApplicationName( "qparseload" );
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription( "Generate load on a PARSE endpoint with many QParse clients and measure them" );
+	parser.addHelpOption();
+	QCommandLineOption baseUrlOption( "base-url", "the url of the PARSE API (default http://127.0.0.1:1337/1, see qparseserver)", "url", "http://127.0.0.1:1337/1" );
+	QCommandLineOption appIdOption( "app-id", "PARSE Application ID", "appId" );
+	QCommandLineOption restKeyOption( "rest-key", "PARSE REST API Key", "restKey" );
+	QCommandLineOption clientsOption( "clients", "the number of clients (default 10)", "n", "10" );
+	QCommandLineOption threadsOption( "threads", "the number of threads running the clients (default 2)", "n", "2" );
+	QCommandLineOption sessionsOption( "sessions", "the concurrent sessions of each client (default 1)", "n", "1" );
+	QCommandLineOption mixOption( "mix", "the operations and their weights (default query=70,save=20,file=10)", "mix", "query=70,save=20,file=10" );
+	QCommandLineOption classOption( "class", "the class of queries and saves (default LoadTest)", "name", "LoadTest" );
+	QCommandLineOption limitOption( "limit", "the limit of the queries (default 20)", "n", "20" );
+	QCommandLineOption fileUrlOption( "file-url", "the url of the file downloaded by the file operation", "url" );
+	QCommandLineOption durationOption( "duration", "the seconds of the measure (default 30)", "s", "30" );
+	QCommandLineOption warmupOption( "warmup", "the seconds before starting the measure (default 5)", "s", "5" );
+	QCommandLineOption thinkOption( "think", "the milliseconds between the operations of a session (default 0)", "ms", "0" );
+	QCommandLineOption rateLimitOption( "rate-limit", "the requests per second of each client (default 0, no limit)", "n", "0" );
+	QCommandLineOption cacheOption( "cache", "let the queries and the files be served by the cache" );
+	QCommandLineOption outputOption( "output", "write the results as Json on the file", "file" );
+	parser.addOption( baseUrlOption );
+	parser.addOption( appIdOption );
+	parser.addOption( restKeyOption );
+	parser.addOption( clientsOption );
+	parser.addOption( threadsOption );
+	parser.addOption( sessionsOption );
+	parser.addOption( mixOption );
+	parser.addOption( classOption );
+	parser.addOption( limitOption );
+	parser.addOption( fileUrlOption );
+	parser.addOption( durationOption );
+	parser.addOption( warmupOption );
+	parser.addOption( thinkOption );
+	parser.addOption( rateLimitOption );
+	parser.addOption( cacheOption );
+	parser.addOption( outputOption );
+	parser.process( app );
+
+	LoadSettings settings;
+	settings.baseUrl = QUrl( parser.value(baseUrlOption) );
+	settings.appId = parser.value( appIdOption );
+	settings.restKey = parser.value( restKeyOption );
+	settings.className = parser.value( classOption );
+	settings.limit = parser.value( limitOption ).toInt();
+	settings.fileUrl = QUrl( parser.value(fileUrlOption) );
+	settings.sessions = qMax( 1, parser.value(sessionsOption).toInt() );
+	settings.think = qMax( 0, parser.value(thinkOption).toInt() );
+	settings.useCache = parser.isSet( cacheOption );
+	settings.rateLimit = parser.value( rateLimitOption ).toDouble();
+	foreach( QString item, parser.value(mixOption).split(",", QString::SkipEmptyParts) ) {
+		QStringList pair = item.split("=");
+		QString op = pair[0].trimmed();
+		int weight = pair.value(1, "1").toInt();
+		if ( op != "query" && op != "save" && op != "file" ) {
+			qCritical() << "Unknown operation" << op;
+			return 1;
+		}
+		if ( weight > 0 ) {
+			settings.mix[op] = weight;
+		}
+	}
+	if ( settings.mix.contains("file") && settings.fileUrl.isEmpty() ) {
+		// without a file, the file operations are not part of the mix
+		settings.mix.remove( "file" );
+	}
+	if ( settings.mix.isEmpty() ) {
+		qCritical() << "No operations in the mix";
+		return 1;
+	}
+	int clientsCount = qMax( 1, parser.value(clientsOption).toInt() );
+	int threadsCount = qBound( 1, parser.value(threadsOption).toInt(), clientsCount );
+	int duration = qMax( 1, parser.value(durationOption).toInt() );
+	int warmup = qMax( 0, parser.value(warmupOption).toInt() );
+
+	// the singleton lives on the main thread, like in the apps
+	QParse::instance();
+	qint64 memoryBefore = residentMemory();
+	QList<QThread*> threads;
+	QList<LoadWorker*> workers;
+	for( int t=0; t<threadsCount; t++ ) {
+		QList<int> ids;
+		for( int id=t; id<clientsCount; id+=threadsCount ) {
+			ids << id;
+		}
+		QThread* thread = new QThread();
+		LoadWorker* worker = new LoadWorker( settings, ids );
+		worker->moveToThread( thread );
+		QObject::connect( thread, &QThread::finished, worker, &QObject::deleteLater );
+		thread->start();
+		threads << thread;
+		workers << worker;
+	}
+
+	int created = 0;
+	int stopped = 0;
+	qint64 memoryClients = 0;
+	double cpuStart = 0;
+	QElapsedTimer measure;
+	QMap<QString, QVector<double> > latencies;
+	QMap<QString, int> errors;
+	foreach( LoadWorker* worker, workers ) {
+		QObject::connect( worker, &LoadWorker::created, &app, [&]() {
+			if ( ++created < workers.size() ) return;
+			memoryClients = residentMemory();
+			qDebug() << "Created" << clientsCount << "clients on" << threadsCount << "threads";
+			foreach( LoadWorker* worker, workers ) {
+				QMetaObject::invokeMethod( worker, "start", Qt::QueuedConnection );
+			}
+			QTimer::singleShot( warmup*1000, &app, [&]() {
+				cpuStart = cpuTime();
+				measure.start();
+				foreach( LoadWorker* worker, workers ) {
+					QMetaObject::invokeMethod( worker, "record", Qt::QueuedConnection );
+				}
+				QTimer::singleShot( duration*1000, &app, [&]() {
+					foreach( LoadWorker* worker, workers ) {
+						QMetaObject::invokeMethod( worker, "stop", Qt::QueuedConnection );
+					}
+				});
+			});
+		});
+		QObject::connect( worker, &LoadWorker::stopped, &app, [&]( QVariantMap results ) {
+			foreach( QString op, results.keys() ) {
+				QVariantMap opData = results[op].toMap();
+				foreach( QVariant value, opData["latencies"].toList() ) {
+					latencies[op] << value.toDouble();
+				}
+				errors[op] += opData["errors"].toInt();
+			}
+			if ( ++stopped == workers.size() ) {
+				app.quit();
+			}
+		});
+		QMetaObject::invokeMethod( worker, "createClients", Qt::QueuedConnection );
+	}
+	app.exec();
+	double elapsed = measure.elapsed()/1000.0;
+	double cpuUsed = cpuTime() - cpuStart;
+	qint64 memoryEnd = residentMemory();
+	foreach( QThread* thread, threads ) {
+		thread->quit();
+		thread->wait();
+		delete thread;
+	}
+
+	QJsonObject report;
+	report["clients"] = clientsCount;
+	report["threads"] = threadsCount;
+	report["sessions"] = settings.sessions;
+	report["seconds"] = elapsed;
+	int total = 0;
+	QJsonObject operations;
+	foreach( QString op, latencies.keys() ) {
+		QVector<double> sorted = latencies[op];
+		std::sort( sorted.begin(), sorted.end() );
+		total += sorted.size();
+		QJsonObject opReport;
+		opReport["count"] = sorted.size();
+		opReport["errors"] = errors[op];
+		opReport["throughput"] = sorted.size()/elapsed;
+		opReport["p50"] = percentile( sorted, 0.50 );
+		opReport["p95"] = percentile( sorted, 0.95 );
+		opReport["p99"] = percentile( sorted, 0.99 );
+		opReport["max"] = sorted.isEmpty() ? 0 : sorted.last();
+		operations[op] = opReport;
+	}
+	report["operations"] = operations;
+	report["throughput"] = total/elapsed;
+	report["cpuMsPerRequest"] = total > 0 ? cpuUsed/total : 0;
+	if ( memoryBefore >= 0 ) {
+		// the memory of the clients just created, and after the load (with caches and buffers)
+		report["memoryPerClientCreated"] = double(memoryClients-memoryBefore)/clientsCount;
+		report["memoryPerClientLoaded"] = double(memoryEnd-memoryBefore)/clientsCount;
+	}
+	QByteArray json = QJsonDocument(report).toJson();
+	QTextStream out( stdout );
+	out << QString("%1 requests in %2 s: %3 req/s, %4 ms CPU per request\n")
+		   .arg(total).arg(elapsed, 0, 'f', 1).arg(total/elapsed, 0, 'f', 1)
+		   .arg(report["cpuMsPerRequest"].toDouble(), 0, 'f', 3);
+	foreach( QString op, operations.keys() ) {
+		QJsonObject opReport = operations[op].toObject();
+		out << QString("  %1: %2 (%3 errors) p50 %4 ms, p95 %5 ms, p99 %6 ms\n")
+			   .arg(op).arg(opReport["count"].toInt()).arg(opReport["errors"].toInt())
+			   .arg(opReport["p50"].toDouble(), 0, 'f', 1).arg(opReport["p95"].toDouble(), 0, 'f', 1)
+			   .arg(opReport["p99"].toDouble(), 0, 'f', 1);
+	}
+	if ( memoryBefore >= 0 ) {
+		out << QString("  memory per client: %1 KB created, %2 KB after the load\n")
+			   .arg(report["memoryPerClientCreated"].toDouble()/1024, 0, 'f', 0)
+			   .arg(report["memoryPerClientLoaded"].toDouble()/1024, 0, 'f', 0);
+	}
+	out.flush();
+	if ( parser.isSet(outputOption) ) {
+		QFile output( parser.value(outputOption) );
+		if ( !output.open( QIODevice::WriteOnly ) ) {
+			qCritical() << "Cannot write" << parser.value(outputOption);
+			return 1;
+		}
+		output.write( json );
+	}
+	return 0;
+}
+
+#include "main.moc"
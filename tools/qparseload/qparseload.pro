@@ -0,0 +1,13 @@
+QT += core network qml
+QT -= gui
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = qparseload
+TEMPLATE = app
+
+include( $$PWD/../../qtparse.pri )
+
+SOURCES += \
+	$$PWD/main.cpp
@@ -0,0 +1,106 @@
+
+#include "qparsepack.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QCryptographicHash>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+
+/*! qparsepack: snapshot a list of PARSE queries and files into a pack
+ *  to bundle into the app as parsecache/parsecache.pack
+ *
+ *  The list contains one entry per line:
+ *    json <url>  -> a Json request (query, object, config)
+ *    file <url>  -> a PARSE file
+ *  The urls must be the same endpoints created by QParse for the requests
+ *  Empty lines and lines starting with # are ignored
+ */
+int main( int argc, char *argv[] ) {
+	QCoreApplication app( argc, argv );
+	QCoreApplication::setApplicationName( "qparsepack" );
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription( "Generate a QParse bundled cache pack from a list of requests" );
+	parser.addHelpOption();
+	QCommandLineOption appIdOption( "app-id", "PARSE Application ID", "appId" );
+	QCommandLineOption restKeyOption( "rest-key", "PARSE REST API Key", "restKey" );
+	QCommandLineOption compressOption( "compress", "compress the Json data bigger than threshold" );
+	QCommandLineOption thresholdOption( "threshold", "minimum size in bytes of compressed Json (default 4096)", "bytes", "4096" );
+	parser.addOption( appIdOption );
+	parser.addOption( restKeyOption );
+	parser.addOption( compressOption );
+	parser.addOption( thresholdOption );
+	parser.addPositionalArgument( "list", "the file containing the list of requests" );
+	parser.addPositionalArgument( "output", "the pack file to generate" );
+	parser.process( app );
+	QStringList args = parser.positionalArguments();
+	if ( args.size() != 2 ) {
+		parser.showHelp( 1 );
+	}
+
+	QFile listFile( args[0] );
+	if ( !listFile.open( QIODevice::ReadOnly | QIODevice::Text ) ) {
+		qCritical() << "Cannot read" << args[0];
+		return 1;
+	}
+	QByteArray appId = parser.value( appIdOption ).toLatin1();
+	QByteArray restKey = parser.value( restKeyOption ).toLatin1();
+	int threshold = parser.value( thresholdOption ).toInt();
+
+	QNetworkAccessManager net;
+	QList<QParsePack::Entry> entries;
+	QTextStream list( &listFile );
+	while( !list.atEnd() ) {
+		QString line = list.readLine().trimmed();
+		if ( line.isEmpty() || line.startsWith("#") ) continue;
+		QString type = line.section( ' ', 0, 0 );
+		QUrl url( line.section( ' ', 1 ).trimmed() );
+		if ( (type != "json" && type != "file") || !url.isValid() ) {
+			qCritical() << "Invalid line:" << line;
+			return 1;
+		}
+		QNetworkRequest request( url );
+		if ( type == "json" ) {
+			request.setRawHeader( "X-Parse-Application-Id", appId );
+			request.setRawHeader( "X-Parse-REST-API-Key", restKey );
+		}
+		QNetworkReply* reply = net.get( request );
+		QEventLoop loop;
+		QObject::connect( reply, &QNetworkReply::finished, &loop, &QEventLoop::quit );
+		loop.exec();
+		if ( reply->error() != QNetworkReply::NoError ) {
+			qCritical() << "Cannot download" << url << reply->errorString();
+			return 1;
+		}
+		QParsePack::Entry entry;
+		entry.url = url;
+		entry.isJson = ( type == "json" );
+		entry.createdAt = QDateTime::currentDateTime();
+		entry.data = reply->readAll();
+		// the hash is always of the decoded data, like QParse does for the cache
+		entry.hash = QString::fromLatin1( QCryptographicHash::hash(entry.data, QCryptographicHash::Sha1).toHex() );
+		if ( entry.isJson && parser.isSet(compressOption) && entry.data.size() >= threshold ) {
+			entry.codec = "zlib";
+			entry.data = qCompress( entry.data, 9 );
+		}
+		if ( !entry.isJson ) {
+			entry.suffix = QFileInfo( url.path() ).suffix();
+		}
+		qDebug() << "Added" << url << entry.data.size() << "bytes";
+		entries << entry;
+		reply->deleteLater();
+	}
+
+	if ( !QParsePack::write( args[1], entries ) ) {
+		qCritical() << "Cannot write" << args[1];
+		return 1;
+	}
+	qDebug() << "Written" << entries.size() << "entries on" << args[1];
+	return 0;
+}
@@ -0,0 +1,17 @@
+QT += core network
+QT -= gui
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = qparsepack
+TEMPLATE = app
+
+INCLUDEPATH += $$PWD/../..
+
+SOURCES += \
+	$$PWD/main.cpp \
+	$$PWD/../../qparsepack.cpp
+
+HEADERS += \
+	$$PWD/../../qparsepack.h
@@ -0,0 +1,91 @@
+#include "parseserver.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QFile>
+#include <QDebug>
+
+//! read a Json object from the file
+static bool readJson( QString filename, QJsonObject* data ) {
+	QFile file( filename );
+	if ( !file.open( QIODevice::ReadOnly ) ) {
+		qCritical() << "Cannot read" << filename;
+		return false;
+	}
+	QJsonDocument doc = QJsonDocument::fromJson( file.readAll() );
+	if ( !doc.isObject() ) {
+		qCritical() << "Not a Json object" << filename;
+		return false;
+	}
+	*data = doc.object();
+	return true;
+}
+
+/*! qparseserver: a local stand-in of the PARSE REST API
+ *
+ *  It keeps the data in memory and answers to QParse like PARSE, so the client can be
+ *  load-tested and measured without network: set the baseUrl of QParse to the url printed
+ *  at startup. The latency, the bandwidth and the errors of a real network can be injected
+ */
+int main( int argc, char *argv[] ) {
+	QCoreApplication app( argc, argv );
+	QCoreApplication::setApplicationName( "qparseserver" );
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription( "Local stand-in of the PARSE REST API for testing QParse without network" );
+	parser.addHelpOption();
+	QCommandLineOption portOption( "port", "the port to listen on (default 1337)", "port", "1337" );
+	QCommandLineOption basePathOption( "base-path", "the path of the API (default /1)", "path", "/1" );
+	QCommandLineOption appIdOption( "app-id", "refuse the requests with another PARSE Application ID", "appId" );
+	QCommandLineOption dataOption( "data", "load the objects from a Json file { \"<class>\": [ {...}, ... ] }", "file" );
+	QCommandLineOption configOption( "config", "the parameters returned by config from a Json file", "file" );
+	QCommandLineOption latencyOption( "latency", "milliseconds before each reply (default 0)", "ms", "0" );
+	QCommandLineOption jitterOption( "jitter", "random milliseconds added to the latency (default 0)", "ms", "0" );
+	QCommandLineOption bandwidthOption( "bandwidth", "bytes per second of the replies (default 0, no limit)", "bytes", "0" );
+	QCommandLineOption errorRateOption( "error-rate", "fraction of the requests failing with error 500 (default 0)", "rate", "0" );
+	QCommandLineOption throttleRateOption( "throttle-rate", "fraction of the requests refused with 429 (default 0)", "rate", "0" );
+	QCommandLineOption verboseOption( "verbose", "print each request" );
+	parser.addOption( portOption );
+	parser.addOption( basePathOption );
+	parser.addOption( appIdOption );
+	parser.addOption( dataOption );
+	parser.addOption( configOption );
+	parser.addOption( latencyOption );
+	parser.addOption( jitterOption );
+	parser.addOption( bandwidthOption );
+	parser.addOption( errorRateOption );
+	parser.addOption( throttleRateOption );
+	parser.addOption( verboseOption );
+	parser.process( app );
+
+	ParseServer::Faults faults;
+	faults.latency = parser.value( latencyOption ).toInt();
+	faults.jitter = parser.value( jitterOption ).toInt();
+	faults.bandwidth = parser.value( bandwidthOption ).toInt();
+	faults.errorRate = parser.value( errorRateOption ).toDouble();
+	faults.throttleRate = parser.value( throttleRateOption ).toDouble();
+	ParseServer server( parser.value(basePathOption), parser.value(appIdOption), faults );
+	server.setVerbose( parser.isSet(verboseOption) );
+	if ( parser.isSet(dataOption) ) {
+		QJsonObject data;
+		if ( !readJson( parser.value(dataOption), &data ) || !server.getStore()->load( data ) ) {
+			return 1;
+		}
+		qDebug() << "Loaded" << server.getStore()->size() << "objects";
+	}
+	if ( parser.isSet(configOption) ) {
+		QJsonObject config;
+		if ( !readJson( parser.value(configOption), &config ) ) {
+			return 1;
+		}
+		server.getStore()->setConfig( config );
+	}
+	if ( !server.listen( QHostAddress::LocalHost, parser.value(portOption).toUShort() ) ) {
+		qCritical() << "Cannot listen on port" << parser.value(portOption) << server.errorString();
+		return 1;
+	}
+	qDebug().noquote() << QString("Listening on http://127.0.0.1:%1%2").arg(server.serverPort()).arg(parser.value(basePathOption));
+	return app.exec();
+}
@@ -0,0 +1,180 @@
+#include "parseserver.h"
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrl>
+#include <QUrlQuery>
+#include <QList>
+#include <QDebug>
+#include <QtGlobal>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+#include <QRandomGenerator>
+#endif
+
+//! the interval of the writes when the bandwidth is limited
+static const int bandwidthInterval = 10;
+
+ParseServer::ParseServer( QString basePath, QString appId, Faults faults, QObject* parent )
+	: QTcpServer(parent)
+	, basePath(basePath)
+	, appId(appId)
+	, faults(faults)
+	, store()
+	, verbose(false)
+	, requests(0)
+	, connections() {
+	if ( this->basePath.endsWith("/") ) {
+		this->basePath.chop(1);
+	}
+	connect( this, &QTcpServer::newConnection, this, &ParseServer::onNewConnection );
+}
+
+ParseStore* ParseServer::getStore() {
+	return &store;
+}
+
+void ParseServer::setVerbose( bool value ) {
+	verbose = value;
+}
+
+qint64 ParseServer::getRequests() const {
+	return requests;
+}
+
+void ParseServer::onNewConnection() {
+	while( hasPendingConnections() ) {
+		QTcpSocket* socket = nextPendingConnection();
+		socket->setSocketOption( QAbstractSocket::LowDelayOption, 1 );
+		connections[socket] = Connection();
+		connect( socket, &QTcpSocket::readyRead, this, &ParseServer::onReadyRead );
+		connect( socket, &QTcpSocket::disconnected, this, &ParseServer::onDisconnected );
+	}
+}
+
+void ParseServer::onReadyRead() {
+	QTcpSocket* socket = qobject_cast<QTcpSocket*>( sender() );
+	if ( !socket || !connections.contains(socket) ) return;
+	connections[socket].buffer.append( socket->readAll() );
+	processNext( socket );
+}
+
+void ParseServer::onDisconnected() {
+	QTcpSocket* socket = qobject_cast<QTcpSocket*>( sender() );
+	connections.remove( socket );
+	// the pending timers of the socket are discarded with it
+	socket->deleteLater();
+}
+
+void ParseServer::processNext( QTcpSocket* socket ) {
+	Connection& connection = connections[socket];
+	if ( connection.busy ) return;
+	int headerEnd = connection.buffer.indexOf( "\r\n\r\n" );
+	if ( headerEnd < 0 ) return;
+	QList<QByteArray> lines = connection.buffer.left( headerEnd ).split( '\n' );
+	QList<QByteArray> requestLine = lines.takeFirst().trimmed().split( ' ' );
+	if ( requestLine.size() != 3 ) {
+		socket->disconnectFromHost();
+		return;
+	}
+	QHash<QByteArray, QByteArray> headers;
+	foreach( QByteArray line, lines ) {
+		int colon = line.indexOf( ':' );
+		if ( colon > 0 ) {
+			headers[line.left(colon).trimmed().toLower()] = line.mid(colon+1).trimmed();
+		}
+	}
+	int contentLength = headers.value("content-length", "0").toInt();
+	if ( connection.buffer.size() < headerEnd+4+contentLength ) return;
+	QByteArray body = connection.buffer.mid( headerEnd+4, contentLength );
+	connection.buffer.remove( 0, headerEnd+4+contentLength );
+	connection.busy = true;
+	connection.close = headers.value("connection").toLower() == "close";
+
+	ParseStore::Response response = handle( requestLine[0], requestLine[1], headers, body );
+	requests++;
+	if ( verbose ) {
+		qDebug() << requestLine[0] << requestLine[1] << response.status << response.body.size() << "bytes";
+	}
+	static const QHash<int, QByteArray> reasons = {
+		{ 200, "OK" }, { 201, "Created" }, { 400, "Bad Request" }, { 401, "Unauthorized" },
+		{ 404, "Not Found" }, { 415, "Unsupported Media Type" }, { 429, "Too Many Requests" },
+		{ 500, "Internal Server Error" }
+	};
+	QByteArray data = "HTTP/1.1 " + QByteArray::number(response.status) + " " + reasons.value(response.status, "Unknown") + "\r\n";
+	data += "Content-Type: " + response.contentType + "\r\n";
+	data += "Content-Length: " + QByteArray::number(response.body.size()) + "\r\n";
+	data += connection.close ? "Connection: close\r\n" : "Connection: keep-alive\r\n";
+	data += "\r\n" + response.body;
+	int delay = faults.latency + random( faults.jitter );
+	QTimer::singleShot( delay, socket, [this, socket, data]() {
+		writeReply( socket, data );
+	});
+}
+
+ParseStore::Response ParseServer::handle( QByteArray method, QByteArray target, QHash<QByteArray, QByteArray> headers, QByteArray body ) {
+	ParseStore::Response response;
+	QUrl url = QUrl::fromEncoded( target );
+	QString path = url.path();
+	if ( !appId.isEmpty() && headers.value("x-parse-application-id") != appId.toLatin1() ) {
+		response.status = 401;
+		response.body = "{\"error\":\"unauthorized\"}";
+	} else if ( chance( faults.throttleRate ) ) {
+		response.status = 429;
+		response.body = ParseStore::errorBody( ParseStore::RequestLimitExceeded, "request limit exceeded" );
+	} else if ( chance( faults.errorRate ) ) {
+		response.status = 500;
+		response.body = ParseStore::errorBody( ParseStore::InternalServerError, "internal server error" );
+	} else if ( !headers.value("content-encoding").isEmpty() && headers.value("content-encoding") != "identity" ) {
+		response.status = 415;
+		response.body = ParseStore::errorBody( ParseStore::InvalidJson, "compressed request bodies are not supported" );
+	} else if ( path != basePath && !path.startsWith(basePath+"/") ) {
+		response.status = 404;
+		response.body = ParseStore::errorBody( ParseStore::InvalidQuery, "unknown endpoint" );
+	} else {
+		QString baseUrl = "http://" + QString::fromLatin1( headers.value("host") ) + basePath;
+		response = store.handle( QString::fromLatin1(method), path.mid(basePath.size()), QUrlQuery(url),
+								 headers.value("content-type"), body, baseUrl );
+	}
+	return response;
+}
+
+void ParseServer::writeReply( QTcpSocket* socket, QByteArray data ) {
+	if ( !connections.contains(socket) ) return;
+	if ( faults.bandwidth > 0 && !data.isEmpty() ) {
+		int chunk = qMax( 1, faults.bandwidth*bandwidthInterval/1000 );
+		socket->write( data.left(chunk) );
+		QByteArray rest = data.mid( chunk );
+		if ( !rest.isEmpty() ) {
+			QTimer::singleShot( bandwidthInterval, socket, [this, socket, rest]() {
+				writeReply( socket, rest );
+			});
+			return;
+		}
+	} else {
+		socket->write( data );
+	}
+	Connection& connection = connections[socket];
+	connection.busy = false;
+	if ( connection.close ) {
+		socket->disconnectFromHost();
+		return;
+	}
+	processNext( socket );
+}
+
+bool ParseServer::chance( double probability ) {
+	if ( probability <= 0 ) return false;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+	return QRandomGenerator::global()->generateDouble() < probability;
+#else
+	return double(qrand())/RAND_MAX < probability;
+#endif
+}
+
+int ParseServer::random( int max ) {
+	if ( max <= 0 ) return 0;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+	return QRandomGenerator::global()->bounded( max+1 );
+#else
+	return qrand() % (max+1);
+#endif
+}
@@ -0,0 +1,76 @@
+#ifndef PARSESERVER_H
+#define PARSESERVER_H
+
+#include <QTcpServer>
+#include <QHash>
+#include <QByteArray>
+#include "parsestore.h"
+
+class QTcpSocket;
+
+/*! A local HTTP server answering like the PARSE REST API (see ParseStore)
+ *
+ *  The connections are kept alive and the requests of a connection are answered in order;
+ *  the faults configured are injected on each request, so the client can be measured
+ *  with the latency and the errors of a real network
+ */
+class ParseServer : public QTcpServer {
+	Q_OBJECT
+public:
+	//! the faults injected on the replies
+	struct Faults {
+		Faults() : latency(0), jitter(0), bandwidth(0), errorRate(0), throttleRate(0) { }
+		//! the milliseconds before replying
+		int latency;
+		//! a random delay up to these milliseconds added to the latency
+		int jitter;
+		//! the bytes per second of the replies; 0 means no limit
+		int bandwidth;
+		//! the fraction of the requests failing with an internal server error
+		double errorRate;
+		//! the fraction of the requests refused for too many requests (HTTP 429, code 155)
+		double throttleRate;
+	};
+	/*! \param basePath the path of the API, like /1
+	 *  \param appId if not empty, the requests with another X-Parse-Application-Id are refused
+	 */
+	ParseServer( QString basePath, QString appId, Faults faults, QObject* parent=0 );
+	ParseStore* getStore();
+	void setVerbose( bool value );
+	//! the number of requests answered
+	qint64 getRequests() const;
+private slots:
+	void onNewConnection();
+	void onReadyRead();
+	void onDisconnected();
+private:
+	//! the state of a connection
+	struct Connection {
+		Connection() : buffer(), busy(false), close(false) { }
+		//! the bytes received and not processed yet
+		QByteArray buffer;
+		//! true while a request is answered; the next ones wait in the buffer
+		bool busy;
+		//! true if the client asked to close the connection after the reply
+		bool close;
+	};
+	//! process the next request of the buffer, if complete
+	void processNext( QTcpSocket* socket );
+	ParseStore::Response handle( QByteArray method, QByteArray target, QHash<QByteArray, QByteArray> headers, QByteArray body );
+	//! write the reply at the bandwidth configured, then process the next request
+	void writeReply( QTcpSocket* socket, QByteArray data );
+	//! return true with the probability
+	static bool chance( double probability );
+	//! return a random number between 0 and max
+	static int random( int max );
+
+	QString basePath;
+	QString appId;
+	Faults faults;
+	ParseStore store;
+	bool verbose;
+	qint64 requests;
+	QHash<QTcpSocket*, Connection> connections;
+};
+
+#endif // PARSESERVER_H
@@ -0,0 +1,409 @@
+#include "parsestore.h"
+#include <QJsonDocument>
+#include <QDateTime>
+#include <QStringList>
+#include <QUrl>
+#include <QtGlobal>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+#include <QRandomGenerator>
+#endif
+#include <algorithm>
+
+//! the maximum number of results of a query, like PARSE
+static const int maxLimit = 1000;
+static const int defaultLimit = 100;
+
+ParseStore::ParseStore()
+	: classes()
+	, files()
+	, config()
+	, baseUrl() {
+}
+
+ParseStore::Response ParseStore::handle( QString method, QString path, QUrlQuery query, QByteArray contentType, QByteArray body, QString baseUrl ) {
+	this->baseUrl = baseUrl;
+	QStringList segments = path.split( "/", QString::SkipEmptyParts );
+	if ( segments.isEmpty() ) {
+		return error( 404, InvalidQuery, "unknown endpoint" );
+	}
+	if ( segments[0] == "files" ) {
+		if ( segments.size() != 2 ) {
+			return error( 404, InvalidQuery, "missing file name" );
+		}
+		if ( method == "POST" ) {
+			// like PARSE, the name is made unique with a prefix
+			QString name = newObjectId()+"-"+segments[1];
+			files[name] = qMakePair( contentType, body );
+			QJsonObject data;
+			data["name"] = name;
+			data["url"] = baseUrl+"/files/"+name;
+			return json( data, 201 );
+		}
+		if ( method == "GET" && files.contains(segments[1]) ) {
+			Response response;
+			response.contentType = files[segments[1]].first;
+			response.body = files[segments[1]].second;
+			return response;
+		}
+		return error( 404, ObjectNotFound, "file not found" );
+	}
+	QJsonObject data;
+	if ( !body.isEmpty() ) {
+		QJsonParseError parseError;
+		QJsonDocument doc = QJsonDocument::fromJson( body, &parseError );
+		if ( parseError.error != QJsonParseError::NoError || !doc.isObject() ) {
+			return error( 400, InvalidJson, "invalid JSON" );
+		}
+		data = doc.object();
+	}
+	return handleJson( method, segments, query, data );
+}
+
+void ParseStore::setConfig( QJsonObject params ) {
+	config = params;
+}
+
+bool ParseStore::load( QJsonObject data ) {
+	foreach( QString className, data.keys() ) {
+		if ( !data[className].isArray() ) return false;
+		foreach( QJsonValue value, data[className].toArray() ) {
+			QJsonObject object = value.toObject();
+			if ( !object.contains("objectId") ) {
+				object["objectId"] = newObjectId();
+			}
+			if ( !object.contains("createdAt") ) {
+				object["createdAt"] = now();
+				object["updatedAt"] = object["createdAt"];
+			}
+			classes[className][object["objectId"].toString()] = object;
+		}
+	}
+	return true;
+}
+
+int ParseStore::size() const {
+	int count = 0;
+	foreach( QString className, classes.keys() ) {
+		count += classes[className].size();
+	}
+	return count;
+}
+
+QByteArray ParseStore::errorBody( int code, QString message ) {
+	QJsonObject data;
+	data["code"] = code;
+	data["error"] = message;
+	return QJsonDocument(data).toJson( QJsonDocument::Compact );
+}
+
+ParseStore::Response ParseStore::handleJson( QString method, QStringList segments, QUrlQuery query, QJsonObject body ) {
+	QString endpoint = segments[0];
+	QString className;
+	QString objectId;
+	if ( endpoint == "classes" && segments.size() >= 2 ) {
+		className = segments[1];
+		objectId = segments.value(2);
+	} else if ( endpoint == "installations" ) {
+		className = "_Installation";
+		objectId = segments.value(1);
+	} else if ( endpoint == "users" ) {
+		className = "_User";
+		objectId = segments.value(1);
+	} else if ( endpoint == "batch" && method == "POST" ) {
+		return batch( body );
+	} else if ( endpoint == "config" && method == "GET" ) {
+		QJsonObject data;
+		data["params"] = config;
+		return json( data );
+	} else if ( endpoint == "login" && method == "GET" ) {
+		return login( query );
+	} else {
+		return error( 404, InvalidQuery, "unknown endpoint" );
+	}
+	if ( method == "GET" ) {
+		if ( objectId.isEmpty() ) {
+			return this->query( className, query );
+		}
+		return getObject( className, objectId, query );
+	} else if ( method == "POST" && objectId.isEmpty() ) {
+		return createObject( className, body );
+	} else if ( method == "PUT" && !objectId.isEmpty() ) {
+		return updateObject( className, objectId, body );
+	} else if ( method == "DELETE" && !objectId.isEmpty() ) {
+		return deleteObject( className, objectId );
+	}
+	return error( 400, InvalidQuery, "invalid method for the endpoint" );
+}
+
+ParseStore::Response ParseStore::query( QString className, QUrlQuery query ) {
+	QJsonObject where;
+	if ( query.hasQueryItem("where") ) {
+		QJsonDocument doc = QJsonDocument::fromJson( query.queryItemValue("where", QUrl::FullyDecoded).toUtf8() );
+		if ( !doc.isObject() ) {
+			return error( 400, InvalidQuery, "invalid where" );
+		}
+		where = doc.object();
+	}
+	QList<QJsonObject> found;
+	foreach( const QJsonObject& object, classes.value(className) ) {
+		if ( matches( object, where ) ) {
+			found << object;
+		}
+	}
+	QStringList order = query.queryItemValue("order", QUrl::FullyDecoded).split( ",", QString::SkipEmptyParts );
+	if ( !order.isEmpty() ) {
+		std::stable_sort( found.begin(), found.end(), [&order]( const QJsonObject& a, const QJsonObject& b ) {
+			foreach( QString key, order ) {
+				bool descending = key.startsWith("-");
+				if ( descending ) key.remove( 0, 1 );
+				int result = compare( a[key], b[key] );
+				if ( result != 0 ) {
+					return descending ? result > 0 : result < 0;
+				}
+			}
+			return false;
+		});
+	}
+	int limit = query.hasQueryItem("limit") ? query.queryItemValue("limit").toInt() : defaultLimit;
+	limit = qBound( 0, limit, maxLimit );
+	int skip = qMax( 0, query.queryItemValue("skip").toInt() );
+	QStringList keys = query.queryItemValue("keys", QUrl::FullyDecoded).split( ",", QString::SkipEmptyParts );
+	QJsonArray results;
+	for( int i=skip; i<found.size() && results.size()<limit; i++ ) {
+		QJsonObject object = found[i];
+		object.remove( "password" );
+		results.append( keys.isEmpty() ? object : selectKeys(object, keys) );
+	}
+	QJsonObject data;
+	data["results"] = results;
+	if ( query.queryItemValue("count") == "1" ) {
+		data["count"] = found.size();
+	}
+	return json( data );
+}
+
+ParseStore::Response ParseStore::getObject( QString className, QString objectId, QUrlQuery query ) {
+	if ( !classes.value(className).contains(objectId) ) {
+		return error( 404, ObjectNotFound, "object not found for get" );
+	}
+	QJsonObject object = classes[className][objectId];
+	object.remove( "password" );
+	QStringList keys = query.queryItemValue("keys", QUrl::FullyDecoded).split( ",", QString::SkipEmptyParts );
+	return json( keys.isEmpty() ? object : selectKeys(object, keys) );
+}
+
+ParseStore::Response ParseStore::createObject( QString className, QJsonObject data ) {
+	QJsonObject object;
+	foreach( QString key, data.keys() ) {
+		QJsonObject op = data[key].toObject();
+		// the operations on a new object start from an empty value
+		if ( op["__op"].toString() == "Increment" ) {
+			object[key] = op["amount"].toDouble();
+		} else if ( op["__op"].toString() != "Delete" ) {
+			object[key] = data[key];
+		}
+	}
+	object["objectId"] = newObjectId();
+	object["createdAt"] = now();
+	object["updatedAt"] = object["createdAt"];
+	classes[className][object["objectId"].toString()] = object;
+	QJsonObject reply;
+	reply["objectId"] = object["objectId"];
+	reply["createdAt"] = object["createdAt"];
+	if ( className == "_User" ) {
+		reply["sessionToken"] = "r:"+newObjectId();
+	}
+	return json( reply, 201 );
+}
+
+ParseStore::Response ParseStore::updateObject( QString className, QString objectId, QJsonObject data ) {
+	if ( !classes.value(className).contains(objectId) ) {
+		return error( 404, ObjectNotFound, "object not found for update" );
+	}
+	QJsonObject& object = classes[className][objectId];
+	foreach( QString key, data.keys() ) {
+		if ( key == "objectId" || key == "createdAt" || key == "updatedAt" ) continue;
+		QJsonObject op = data[key].toObject();
+		QString opName = op["__op"].toString();
+		if ( opName == "Increment" ) {
+			object[key] = object[key].toDouble() + op["amount"].toDouble();
+		} else if ( opName == "Delete" ) {
+			object.remove( key );
+		} else {
+			object[key] = data[key];
+		}
+	}
+	object["updatedAt"] = now();
+	QJsonObject reply;
+	reply["updatedAt"] = object["updatedAt"];
+	return json( reply );
+}
+
+ParseStore::Response ParseStore::deleteObject( QString className, QString objectId ) {
+	if ( classes[className].remove(objectId) == 0 ) {
+		return error( 404, ObjectNotFound, "object not found for delete" );
+	}
+	return json( QJsonObject() );
+}
+
+ParseStore::Response ParseStore::batch( QJsonObject body ) {
+	QJsonArray requests = body["requests"].toArray();
+	if ( requests.size() > 50 ) {
+		return error( 400, InvalidQuery, "too many operations in the batch" );
+	}
+	// the paths of the batch are absolute, like /1/classes/Post
+	QString basePath = QUrl(baseUrl).path();
+	QJsonArray results;
+	foreach( QJsonValue value, requests ) {
+		QJsonObject request = value.toObject();
+		QString path = request["path"].toString();
+		if ( path.startsWith(basePath) ) {
+			path = path.mid( basePath.size() );
+		}
+		QStringList segments = path.split( "/", QString::SkipEmptyParts );
+		QJsonObject result;
+		Response response;
+		if ( segments.isEmpty() || segments[0] == "batch" || segments[0] == "files" ) {
+			response = error( 400, InvalidQuery, "invalid path in batch" );
+		} else {
+			response = handleJson( request["method"].toString(), segments, QUrlQuery(), request["body"].toObject() );
+		}
+		QJsonObject data = QJsonDocument::fromJson( response.body ).object();
+		if ( response.status >= 400 ) {
+			result["error"] = data;
+		} else {
+			result["success"] = data;
+		}
+		results.append( result );
+	}
+	Response response;
+	response.body = QJsonDocument(results).toJson( QJsonDocument::Compact );
+	return response;
+}
+
+ParseStore::Response ParseStore::login( QUrlQuery query ) {
+	QString username = query.queryItemValue( "username", QUrl::FullyDecoded );
+	QString password = query.queryItemValue( "password", QUrl::FullyDecoded );
+	foreach( QJsonObject user, classes.value("_User") ) {
+		if ( user["username"].toString() == username && user["password"].toString() == password ) {
+			user.remove( "password" );
+			user["sessionToken"] = "r:"+newObjectId();
+			return json( user );
+		}
+	}
+	return error( 404, ObjectNotFound, "invalid username/password" );
+}
+
+bool ParseStore::matches( const QJsonObject& object, const QJsonObject& where ) {
+	foreach( QString key, where.keys() ) {
+		if ( key == "$or" ) {
+			bool any = false;
+			foreach( QJsonValue alternative, where[key].toArray() ) {
+				if ( matches( object, alternative.toObject() ) ) {
+					any = true;
+					break;
+				}
+			}
+			if ( !any ) return false;
+		} else if ( !matchesConstraint( object.value(key), where[key] ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ParseStore::matchesConstraint( const QJsonValue& value, const QJsonValue& constraint ) {
+	QJsonObject operators = constraint.toObject();
+	bool isOperator = !operators.isEmpty() && operators.keys().first().startsWith("$");
+	if ( !isOperator ) {
+		// equality, or the array contains the value
+		if ( value.isArray() && !constraint.isArray() ) {
+			return value.toArray().contains( constraint );
+		}
+		return value == constraint;
+	}
+	foreach( QString op, operators.keys() ) {
+		QJsonValue operand = operators[op];
+		bool ok = true;
+		if ( op == "$ne" ) {
+			ok = value != operand;
+		} else if ( op == "$in" ) {
+			ok = operand.toArray().contains( value );
+		} else if ( op == "$nin" ) {
+			ok = !operand.toArray().contains( value );
+		} else if ( op == "$exists" ) {
+			ok = value.isUndefined() != operand.toBool();
+		} else if ( op == "$lt" ) {
+			ok = !value.isUndefined() && compare( value, operand ) < 0;
+		} else if ( op == "$lte" ) {
+			ok = !value.isUndefined() && compare( value, operand ) <= 0;
+		} else if ( op == "$gt" ) {
+			ok = !value.isUndefined() && compare( value, operand ) > 0;
+		} else if ( op == "$gte" ) {
+			ok = !value.isUndefined() && compare( value, operand ) >= 0;
+		}
+		if ( !ok ) return false;
+	}
+	return true;
+}
+
+int ParseStore::compare( const QJsonValue& a, const QJsonValue& b ) {
+	if ( a.type() != b.type() ) {
+		return a.type() < b.type() ? -1 : 1;
+	}
+	switch( a.type() ) {
+	case QJsonValue::Double:
+		return a.toDouble() < b.toDouble() ? -1 : ( a.toDouble() > b.toDouble() ? 1 : 0 );
+	case QJsonValue::String:
+		return a.toString().compare( b.toString() );
+	case QJsonValue::Bool:
+		return int(a.toBool()) - int(b.toBool());
+	case QJsonValue::Object:
+		// the dates are ordered by their ISO representation
+		return a.toObject()["iso"].toString().compare( b.toObject()["iso"].toString() );
+	default:
+		return 0;
+	}
+}
+
+QJsonObject ParseStore::selectKeys( const QJsonObject& object, QStringList keys ) {
+	QJsonObject selected;
+	keys << "objectId" << "createdAt" << "updatedAt";
+	foreach( QString key, keys ) {
+		if ( object.contains(key) ) {
+			selected[key] = object[key];
+		}
+	}
+	return selected;
+}
+
+ParseStore::Response ParseStore::json( QJsonObject data, int status ) {
+	Response response;
+	response.status = status;
+	response.body = QJsonDocument(data).toJson( QJsonDocument::Compact );
+	return response;
+}
+
+ParseStore::Response ParseStore::error( int status, int code, QString message ) {
+	Response response;
+	response.status = status;
+	response.body = errorBody( code, message );
+	return response;
+}
+
+QString ParseStore::newObjectId() {
+	static const char chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+	QString objectId;
+	for( int i=0; i<10; i++ ) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+		objectId += QChar( chars[QRandomGenerator::global()->bounded(62)] );
+#else
+		objectId += QChar( chars[qrand() % 62] );
+#endif
+	}
+	return objectId;
+}
+
+QString ParseStore::now() {
+	return QDateTime::currentDateTimeUtc().toString( "yyyy-MM-dd'T'HH:mm:ss.zzz'Z'" );
+}
@@ -0,0 +1,89 @@
+#ifndef PARSESTORE_H
+#define PARSESTORE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QMap>
+#include <QPair>
+#include <QUrlQuery>
+#include <QJsonObject>
+#include <QJsonArray>
+
+/*! The data of the stand-in server and the implementation of the PARSE REST API on them
+ *
+ *  It implements the subset of the API used by QParse:
+ *    classes/<class>[/<objectId>]: GET (query or object), POST, PUT, DELETE
+ *        the queries support where (equality, $in, $nin, $ne, $lt, $lte, $gt, $gte, $exists),
+ *        order, keys, limit, skip and count
+ *    batch: POST with the requests of the objects
+ *    files/<name>: POST the content of a file; GET returns it back
+ *    config: GET the parameters set with setConfig
+ *    installations[/<objectId>], users[/<objectId>]: like the classes _Installation and _User
+ *    login: GET with username and password of a user
+ *
+ *  All the paths are relative to the base path of the API (like /1)
+ */
+class ParseStore {
+public:
+	//! the reply to a request
+	struct Response {
+		Response() : status(200), contentType("application/json"), body() { }
+		int status;
+		QByteArray contentType;
+		QByteArray body;
+	};
+	ParseStore();
+	/*! perform the request
+	 *  \param path the path relative to the base path of the API (like classes/Post/xyz)
+	 *  \param baseUrl the url of the API, for the urls of the files
+	 */
+	Response handle( QString method, QString path, QUrlQuery query, QByteArray contentType, QByteArray body, QString baseUrl );
+	//! the parameters returned by config
+	void setConfig( QJsonObject params );
+	//! load the objects of the classes from Json: { "<class>": [ {object}, ... ], ... }
+	bool load( QJsonObject classes );
+	//! return the number of objects stored
+	int size() const;
+	//! the PARSE errors used by the server
+	enum ErrorCode {
+		InternalServerError = 1,
+		ObjectNotFound = 101,
+		InvalidQuery = 102,
+		InvalidJson = 107,
+		RequestLimitExceeded = 155
+	};
+	//! return the Json body of a PARSE error
+	static QByteArray errorBody( int code, QString message );
+private:
+	Response handleJson( QString method, QStringList segments, QUrlQuery query, QJsonObject body );
+	Response query( QString className, QUrlQuery query );
+	Response getObject( QString className, QString objectId, QUrlQuery query );
+	Response createObject( QString className, QJsonObject data );
+	Response updateObject( QString className, QString objectId, QJsonObject data );
+	Response deleteObject( QString className, QString objectId );
+	Response batch( QJsonObject body );
+	Response login( QUrlQuery query );
+	//! return true if the object matches the constraints of the where
+	static bool matches( const QJsonObject& object, const QJsonObject& where );
+	static bool matchesConstraint( const QJsonValue& value, const QJsonValue& constraint );
+	//! compare two values of the same type; used by order and by $lt, $gt, ...
+	static int compare( const QJsonValue& a, const QJsonValue& b );
+	//! return the object with only the keys (plus the PARSE fields)
+	static QJsonObject selectKeys( const QJsonObject& object, QStringList keys );
+	//! return a Json reply
+	static Response json( QJsonObject data, int status=200 );
+	static Response error( int status, int code, QString message );
+	//! return a new random objectId
+	static QString newObjectId();
+	//! return the current time in the PARSE format
+	static QString now();
+
+	//! the objects by class and objectId
+	QMap<QString, QMap<QString, QJsonObject> > classes;
+	//! the files by name: content type and content
+	QMap<QString, QPair<QByteArray, QByteArray> > files;
+	QJsonObject config;
+	QString baseUrl;
+};
+
+#endif // PARSESTORE_H
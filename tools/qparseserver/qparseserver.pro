@@ -0,0 +1,17 @@
+QT += core network
+QT -= gui
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+TARGET = qparseserver
+TEMPLATE = app
+
+SOURCES += \
+	$$PWD/main.cpp \
+	$$PWD/parsestore.cpp \
+	$$PWD/parseserver.cpp
+
+HEADERS += \
+	$$PWD/parsestore.h \
+	$$PWD/parseserver.h